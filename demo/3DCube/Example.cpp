@@ -37,7 +37,6 @@ Example::Example()
 
 	mCurrentRenderWindow = nullptr;
 
-	mHotReloadShaders = {};
 	mShaderInformation = {};
 }
 
@@ -417,6 +416,9 @@ void Example::Prepare()
 /// </summary>
 void Example::PrepareHotReloadShaders()
 {
+	// Same cache as ShaderBuilder ( ShaderBuilder Shaders.manifest -cache ShaderCache )
+	mHotReloadShaders.SetCacheDirectory("ShaderCache");
+
 	// Add pixel shader
 	mShaderInformation.bSaveToCSO = true; // Future 
 	mShaderInformation.entryPoint = "main"; // Set entry point for shader
@@ -459,4 +461,13 @@ void Example::PrepareHotReloadShaders()
 			}
 		}
 		});
+
+	// Compile both shaders in parallel before first frame, callback is called only for next reloads
+	mHotReloadShaders.AddBundleTag("BasicPixelShader", "Cube");
+	mHotReloadShaders.AddBundleTag("BasicVertexShader", "Cube");
+	if (mHotReloadShaders.WarmUp("Cube"))
+	{
+		mHotReloadShaders.BindCompiledShader<HotReloadableShaderType::VertexShader>("BasicVertexShader", mRenderDeviceContext);
+		mHotReloadShaders.BindCompiledShader<HotReloadableShaderType::PixelShader>("BasicPixelShader", mRenderDeviceContext);
+	}
 }
@@ -19,14 +19,142 @@
 #include <functional>
 #include <mutex>
 #include <map>
+#include <algorithm>
+#include <string>
+#include <deque>
+#include <chrono>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <string_view>
+#include <future>
 
 #include <d3d11.h>
+#include <d3d11shader.h>
 #include <d3dcompiler.h>
 
+// Flags passed to D3DCompile
+// Runtime and offline builds (ShaderBuilder) must use same flags, otherwise cache keys not match
+#ifndef HOT_RELOADABLE_SHADERS_COMPILE_FLAGS
+#define HOT_RELOADABLE_SHADERS_COMPILE_FLAGS 0
+#endif
+
+// Flags of fast (iteration) tier, used by HotReloadableShaders::SetIterationMode
+#ifndef HOT_RELOADABLE_SHADERS_ITERATION_COMPILE_FLAGS
+#define HOT_RELOADABLE_SHADERS_ITERATION_COMPILE_FLAGS (HOT_RELOADABLE_SHADERS_COMPILE_FLAGS | D3DCOMPILE_SKIP_OPTIMIZATION)
+#endif
+
+// 0 - trace scopes is compiled out, ShaderTracer is still available but records nothing from library
+#ifndef HOT_RELOADABLE_SHADERS_TRACE
+#define HOT_RELOADABLE_SHADERS_TRACE 1
+#endif
+
+// Named pipe of out-of-process compile service (ShaderCompileDaemon)
+#ifndef HOT_RELOADABLE_SHADERS_SERVICE_PIPE
+#define HOT_RELOADABLE_SHADERS_SERVICE_PIPE "\\\\.\\pipe\\HotReloadableShaders"
+#endif
+
+// Values is stored in archives and sent to compile service, new stages is added to the end
 enum class HotReloadableShaderType
 {
 	VertexShader,
-	PixelShader
+	PixelShader,
+	GeometryShader,
+	HullShader,
+	DomainShader,
+	ComputeShader
+};
+
+/// <summary>
+/// Compile-time traits of shader stage: interface, default profile, create and bind functions of D3D11
+/// </summary>
+template<HotReloadableShaderType Type>
+struct ShaderStageTraits;
+
+template<>
+struct ShaderStageTraits<HotReloadableShaderType::VertexShader>
+{
+	typedef ID3D11VertexShader Interface;
+	static constexpr const char* defaultProfile = "vs_5_0";
+	static constexpr auto create = &ID3D11Device::CreateVertexShader;
+	static constexpr auto bind = &ID3D11DeviceContext::VSSetShader;
+};
+
+template<>
+struct ShaderStageTraits<HotReloadableShaderType::PixelShader>
+{
+	typedef ID3D11PixelShader Interface;
+	static constexpr const char* defaultProfile = "ps_5_0";
+	static constexpr auto create = &ID3D11Device::CreatePixelShader;
+	static constexpr auto bind = &ID3D11DeviceContext::PSSetShader;
+};
+
+template<>
+struct ShaderStageTraits<HotReloadableShaderType::GeometryShader>
+{
+	typedef ID3D11GeometryShader Interface;
+	static constexpr const char* defaultProfile = "gs_5_0";
+	static constexpr auto create = &ID3D11Device::CreateGeometryShader;
+	static constexpr auto bind = &ID3D11DeviceContext::GSSetShader;
+};
+
+template<>
+struct ShaderStageTraits<HotReloadableShaderType::HullShader>
+{
+	typedef ID3D11HullShader Interface;
+	static constexpr const char* defaultProfile = "hs_5_0";
+	static constexpr auto create = &ID3D11Device::CreateHullShader;
+	static constexpr auto bind = &ID3D11DeviceContext::HSSetShader;
+};
+
+template<>
+struct ShaderStageTraits<HotReloadableShaderType::DomainShader>
+{
+	typedef ID3D11DomainShader Interface;
+	static constexpr const char* defaultProfile = "ds_5_0";
+	static constexpr auto create = &ID3D11Device::CreateDomainShader;
+	static constexpr auto bind = &ID3D11DeviceContext::DSSetShader;
+};
+
+template<>
+struct ShaderStageTraits<HotReloadableShaderType::ComputeShader>
+{
+	typedef ID3D11ComputeShader Interface;
+	static constexpr const char* defaultProfile = "cs_5_0";
+	static constexpr auto create = &ID3D11Device::CreateComputeShader;
+	static constexpr auto bind = &ID3D11DeviceContext::CSSetShader;
+};
+
+/// <summary>
+/// Functions of stage for bundle, which type is known only at runtime
+/// Resolved once per bundle, so creating and binding is not branched by stage
+/// </summary>
+struct ShaderStageFunctions
+{
+	bool (*create)(ID3D11Device* device, const void* bytecode, size_t bytecodeSize, IUnknown** shader);
+	void (*bind)(ID3D11DeviceContext* context, IUnknown* shader);
+	const char* defaultProfile;
+};
+
+// Functions of stage, nullptr for unknown type
+inline const ShaderStageFunctions* GetShaderStageFunctions(HotReloadableShaderType type);
+
+// Which compile flags is used for created shader
+enum class ShaderCompileTier
+{
+	// HOT_RELOADABLE_SHADERS_COMPILE_FLAGS
+	Optimized,
+
+	// HOT_RELOADABLE_SHADERS_ITERATION_COMPILE_FLAGS, replaced by optimized when file is quiet
+	Iteration
+};
+
+// Compile timings of bundle, 0 if tier was not compiled
+struct ShaderCompileTimings
+{
+	double iterationMilliseconds;
+	double optimizedMilliseconds;
 };
 
 struct CompiledQueue
@@ -36,6 +164,7 @@ struct CompiledQueue
 
 /// <summary>
 /// Hot reloadable shader information
+/// Strings is copied by AddNewBundle
 /// </summary>
 struct ShaderInformation
 {
@@ -46,7 +175,8 @@ struct ShaderInformation
 	HotReloadableShaderType localShaderType;
 
 	// Shader type
-	// ps_(version)/vs_(version)
+	// ps_(version)/vs_(version)/gs_/hs_/ds_/cs_
+	// nullptr - default profile of stage (ShaderStageTraits)
 	const char* shaderVersion;
 
 	// Entry point in shaders
@@ -60,7 +190,7 @@ struct ShaderInformation
 	bool bSaveToCSO;
 
 	// Allow system after compilation to bind Your shaders
-	// *Note* for this function your must pass your ID3D11Pixel(Vertex)Shaders
+	// *Note* new shaders is bound on mRenderDeviceContext of every device of bundle (bind function of ShaderStageTraits)
 	bool isAutomationBind;
 
 	// Last time when file is be changed
@@ -74,433 +204,7137 @@ struct ShaderInformation
 	};
 
 	// Render devices
+	// *Note* more devices can be added by HotReloadableShaders::AddBundleDevice
 	D3DRenderDevices renderDevices;
 };
 
-class HotReloadableShaders
+// Compile profile of bundle, default profile of stage when shaderVersion is not set
+inline const char* GetShaderProfile(const ShaderInformation& info);
+
+enum class ShaderDiagnosticSeverity
+{
+	Info,
+	Warning,
+	Error
+};
+
+/// <summary>
+/// One parsed diagnostic record
+/// </summary>
+struct ShaderDiagnostic
+{
+	ShaderDiagnosticSeverity severity;
+
+	// Bundle which is reported it, can be empty
+	std::string localName;
+
+	// Position in source, line and column is 0 if unknown
+	std::string file;
+	int line;
+	int column;
+
+	// Compiler code (X3000), can be empty
+	std::string code;
+	std::string message;
+
+	// How many same records is suppressed before this one
+	unsigned int repeatCount;
+
+	// Compile pass in which record is reported, set by Report
+	unsigned long long pass;
+};
+
+/// <summary>
+/// Asynchronous diagnostics channel
+/// Producers (any thread) never lock and never allocate: records is copied in preallocated ring, strings of slots keep their capacity.
+/// Records is deduplicated, rate-limited and written to sinks by background thread
+/// </summary>
+class ShaderDiagnostics
 {
 public:
-	HotReloadableShaders();
-	~HotReloadableShaders();
+	typedef std::function<void(const ShaderDiagnostic&)> Sink;
 
-	// Add new shader information
-	void AddNewBundle(ShaderInformation& information);
+	ShaderDiagnostics();
+	~ShaderDiagnostics();
 
-	// Start watching
-	void Start();
+	// Add record in queue, lock-free, record is dropped (and counted) if queue is full
+	void Report(const ShaderDiagnostic& diagnostic);
 
-	// Bring system get Shader information data
-	ShaderInformation* GetShaderInformationByLocalName(const char* localName);
+	// Add simple record in queue
+	void Report(ShaderDiagnosticSeverity severity, const char* localName, const char* file, const char* message);
 
-	// Have the shaders been compiled
-	bool IsCompiled();
+	// Parse compiler output (errors and warnings) and add records in queue
+	void ReportCompilerOutput(const char* localName, const char* output);
 
-	// Get compiled shaders type
-	std::vector<CompiledQueue> GetCompiledShadersType();
+	// Add sink, sinks is called from background thread
+	void AddSink(Sink sink);
 
-	// Get compiled shader by local name
-	template<typename T>
-	T GetCompiledShaderByLocalName(const char* localName);
+	// Remove all sinks (console sink is added by default)
+	void ClearSinks();
 
-	// Set custom callback, which called when shaders is compiled
-	void ActionIfCompiled(std::function<void()> callback);
+	// Same records (file, line, column, message) of one compile pass in this window is written once, for all bundles
+	void SetDeduplicationWindow(unsigned int milliseconds);
+
+	// Start new compile pass (change set, save of file), records of previous pass is not suppressing new ones
+	void BeginPass();
+
+	// Bundle can write not more than maxRecords in window, other is counted and reported later
+	void SetRateLimit(unsigned int maxRecords, unsigned int milliseconds);
+
+	// Wait until all records is written, file sinks is flushed
+	void Flush();
+
+	// Sink which prints records in console
+	static Sink MakeConsoleSink();
+
+	// Sink which appends records in file, file is kept open and flushed by Flush()
+	static Sink MakeFileSink(const char* path);
+
+	// Slots of queue, power of two
+	static constexpr size_t QueueCapacity = 1024;
 
 protected:
+	// State of file sink, it is found in sinks by Flush()
+	struct FileSink
+	{
+		std::shared_ptr<FILE> file;
+		void operator()(const ShaderDiagnostic& diagnostic) const;
+	};
 
-	// Generate .cso files for compiled shaders
-	void GenerateCSO(ShaderInformation& info, void* buffer, int bufferSize);
+	// Take free slot, fill it and publish it
+	template <typename Fill>
+	void Push(const Fill& fill);
 
-	// Watch for files
-	void StartWatch();
+	// Background thread loop
+	void WorkerLoop();
 
-	// Compile file
-	bool CompileFile(ShaderInformation& info);
+	// Dedupe, rate-limit and write record
+	void Process(ShaderDiagnostic& diagnostic);
 
-	// Create pixel shader
-	bool CreatePixelShader(ShaderInformation& info, ID3DBlob* shader);
+	// Write summaries of bundles which rate limit window is passed, all summaries if isAll
+	void FlushRateSummaries(std::chrono::steady_clock::time_point now, bool isAll);
 
-	// Create vertex shader
-	bool CreateVertexShader(ShaderInformation& info, ID3DBlob* shader);
+	// Write record in all sinks
+	void Emit(const ShaderDiagnostic& diagnostic);
 
 private:
-	std::vector<ShaderInformation> mShadersInformation;
-	std::vector<CompiledQueue> mCompiledShaders;
-	std::map<const char*, unsigned long long> mTimeChanged;
+	// Slot of bounded lock-free queue, sequence tells who owns it (producer of position or consumer)
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		ShaderDiagnostic diagnostic;
+	};
 
-	bool bIsCompiled;
-	std::map<const char*, IUnknown*> mCompiledShadersA;
+	std::unique_ptr<Cell[]> mCells;
+	std::atomic<size_t> mEnqueuePosition;
+	size_t mDequeuePosition;
 
-	std::function<void()> mCustomCallbackWhenShadersIsCompiled;
+	std::atomic<unsigned long long> mReportedCount;
+	std::atomic<unsigned long long> mProcessedCount;
+	std::atomic<unsigned long long> mDroppedCount;
+
+	std::mutex mSinksMutex;
+	std::vector<Sink> mSinks;
+
+	// Used only for sleeping of background thread, producers never lock it
+	std::mutex mWakeMutex;
+	std::condition_variable mWake;
+	std::atomic<bool> bIsStopping;
+	std::thread mWorker;
+
+	// Background thread state
+	struct SeenRecord
+	{
+		std::chrono::steady_clock::time_point time;
+		unsigned int suppressed;
+	};
+	std::map<unsigned long long, SeenRecord> mSeenRecords;
+
+	struct BundleRate
+	{
+		std::chrono::steady_clock::time_point windowStart;
+		unsigned int count;
+		unsigned int dropped;
+	};
+	std::map<std::string, BundleRate> mBundleRates;
+
+	std::atomic<unsigned long long> mPass;
+	std::atomic<unsigned int> mDeduplicationWindow;
+	std::atomic<unsigned int> mRateLimitRecords;
+	std::atomic<unsigned int> mRateLimitWindow;
 };
 
+// Process-wide diagnostics channel
+inline ShaderDiagnostics& GetShaderDiagnostics();
+
 /// <summary>
-/// Constructor
+/// One traced stage of hot reload pipeline
 /// </summary>
-inline HotReloadableShaders::HotReloadableShaders()
+struct ShaderTraceEvent
 {
-	bIsCompiled = false;
-}
+	// Stage name, must be static string
+	const char* stage;
+
+	// Bundle, truncated
+	char localName[48];
+
+	// Microseconds from tracer creation
+	unsigned long long start;
+	unsigned long long duration;
+};
 
 /// <summary>
-/// Destructor
+/// Low-overhead tracer of hot reload pipeline
+/// Every thread writes events in its own ring buffer, buffers is exported as Chrome trace JSON (chrome://tracing, Perfetto)
+/// When tracer is disabled scope costs one atomic load
 /// </summary>
-inline HotReloadableShaders::~HotReloadableShaders()
+class ShaderTracer
 {
-	mShadersInformation.clear();
-	mCompiledShaders.clear();
-	mTimeChanged.clear();
+public:
+	ShaderTracer();
+
+	// Start or stop recording
+	void SetEnabled(bool isEnabled);
+	bool IsEnabled();
 
-	for (auto& r : mCompiledShadersA)
+	// How many last events is kept by every thread, used for buffers created after call
+	void SetBufferSize(unsigned int eventCount);
+
+	// Record finished stage
+	void Record(const char* stage, const char* localName, unsigned long long start, unsigned long long end);
+
+	// Microseconds from tracer creation
+	unsigned long long GetMicroseconds();
+
+	// Remove recorded events
+	void Clear();
+
+	// Build Chrome trace JSON from all threads
+	std::string ExportChromeTrace();
+
+	// Write Chrome trace JSON in file
+	bool ExportChromeTrace(const char* path);
+
+private:
+	// Ring buffer of one thread
+	struct ThreadBuffer
 	{
-		if (r.second)
-		{
-			r.second->Release();
-			r.second = nullptr;
-		}
-	}
-}
+		unsigned int threadId;
+		std::vector<ShaderTraceEvent> events;
+		unsigned long long written;
 
-/// <summary>
-/// Add new shader information
-/// </summary>
-/// <param name="information">Information with your shaders which is enable hot reload</param>
-inline void HotReloadableShaders::AddNewBundle(ShaderInformation& information)
-{
-	mShadersInformation.push_back(information);
-	mTimeChanged[information.localName] = 0;
-	mCompiledShadersA[information.localName] = nullptr;
-}
+		// Only contended while export or clear
+		std::mutex mutex;
+	};
+
+	// Buffer of calling thread, created on first event
+	ThreadBuffer* GetThreadBuffer();
+
+	std::atomic<bool> bIsEnabled;
+	std::atomic<unsigned int> mBufferSize;
+	std::chrono::steady_clock::time_point mStartTime;
+
+	std::mutex mBuffersMutex;
+	std::vector<std::shared_ptr<ThreadBuffer>> mBuffers;
+};
+
+// Process-wide tracer
+inline ShaderTracer& GetShaderTracer();
 
 /// <summary>
-/// Start watching
+/// Scoped trace event, recorded in destructor
 /// </summary>
-inline void HotReloadableShaders::Start()
+class ShaderTraceScope
 {
-	// Watching 
-	StartWatch();
-}
+public:
+	ShaderTraceScope(const char* stage, const char* localName = nullptr);
+	~ShaderTraceScope();
+
+private:
+	const char* mStage;
+	const char* mLocalName;
+	unsigned long long mStart;
+	bool bIsEnabled;
+};
+
+// Raw size of one block of compressed stream
+constexpr size_t ShaderCompressionBlockSize = 64 * 1024;
+
+// Flag in header of block: block is stored without compression
+constexpr unsigned int ShaderCompressionStoredBlock = 0x80000000u;
+
+// Compress bytes in stream of LZ4 blocks, stream can be decompressed block by block while it is read
+inline void CompressShaderBytes(const void* data, size_t size, std::vector<unsigned char>& compressed);
+
+// Decompress stream of LZ4 blocks
+inline bool DecompressShaderBytes(const void* data, size_t size, void* destination, size_t destinationSize);
 
 /// <summary>
-/// Bring system get Shader information data
+/// Persisted cache of compiled bytecode
+/// Entries is compressed, bytecode is kept with reflection (runtime reads cost of shader from it)
+/// Shared by runtime and offline builds (ShaderBuilder), one file per compile key
 /// </summary>
-/// <param name="localName">local name of shader information</param>
-/// <returns>Shader information</returns>
-inline ShaderInformation* HotReloadableShaders::GetShaderInformationByLocalName(const char* localName)
+class ShaderCache
 {
-	// try find shader information
-	for (auto& info : mShadersInformation)
-	{
-		if (!strcmp(info.localName, localName))
-			return &info;
-	}
+public:
+	ShaderCache();
 
-	return nullptr;
-}
+	// Set cache directory, if directory is not exist - it will be created
+	void SetDirectory(const char* directory);
+
+	// Is cache enabled
+	bool IsEnabled();
+
+	// Try load bytecode by compile key
+	bool Load(unsigned long long key, std::vector<unsigned char>& bytecode);
+
+	// Store bytecode by compile key
+	bool Store(unsigned long long key, const void* bytecode, size_t bytecodeSize);
+
+protected:
+
+	// Get path to cache file
+	std::string GetEntryPath(unsigned long long key);
+
+private:
+	std::string mDirectory;
+	std::mutex mMutex;
+};
 
 /// <summary>
-/// Have the shaders been compiled
+/// State of job scheduler
 /// </summary>
-/// <returns></returns>
-inline bool HotReloadableShaders::IsCompiled()
+struct ShaderSchedulerStatistics
 {
-	return bIsCompiled;
-}
+	unsigned int threadCount;
+	// Count of jobs which can run at once now (max concurrency and frame pressure)
+	unsigned int concurrency;
+	unsigned int queueDepth;
+	unsigned int activeJobs;
+	unsigned long long completedJobs;
+	// Busy time of workers / (time * thread count) since previous GetStatistics, 0..1
+	double utilization;
+};
 
 /// <summary>
-/// Get compiled shaders type
+/// Simple job scheduler for parallel shaders compilation
 /// </summary>
-/// <returns></returns>
-inline std::vector<CompiledQueue> HotReloadableShaders::GetCompiledShadersType()
+class ShaderJobScheduler
 {
-	return mCompiledShaders;
-}
+public:
+	// 0 - use all hardware threads
+	ShaderJobScheduler(unsigned int threadCount = 0);
+	~ShaderJobScheduler();
+
+	// Add new job in queue
+	void Submit(std::function<void()> job);
+
+	// Wait until all jobs is done
+	void Wait();
+
+	// Get count of worker threads
+	unsigned int GetThreadCount();
+
+	// Max count of jobs which run at once, 0 - count of threads
+	void SetMaxConcurrency(unsigned int count);
+
+	// Jobs which run at once under frame pressure, it is lowered by host and never above max concurrency
+	void SetThrottle(unsigned int count);
+
+	// OS priority of worker threads (THREAD_PRIORITY_*)
+	void SetThreadPriority(int priority);
+
+	// CPU affinity of worker threads, 0 - all CPUs of process
+	void SetAffinityMask(unsigned long long mask);
+
+	// Queue depth and utilization
+	ShaderSchedulerStatistics GetStatistics();
+
+protected:
+
+	// Worker thread loop
+	void WorkerLoop(unsigned int index);
+
+	// Count of jobs which can run at once, under lock
+	unsigned int GetConcurrency();
+
+private:
+	std::vector<std::thread> mWorkers;
+	std::deque<std::function<void()>> mJobs;
+
+	std::mutex mMutex;
+	std::condition_variable mJobAvailable;
+	std::condition_variable mJobsDone;
+
+	unsigned int mActiveJobs;
+	bool bIsStopping;
+
+	// Limits
+	unsigned int mMaxConcurrency;
+	unsigned int mThrottle;
+
+	// Thread settings, workers apply them when generation is changed
+	int mPriority;
+	unsigned long long mAffinityMask;
+	unsigned int mSettingsGeneration;
+
+	// Utilization
+	unsigned long long mCompletedJobs;
+	std::chrono::steady_clock::duration mBusyTime;
+	std::chrono::steady_clock::time_point mStatisticsTime;
+	std::vector<std::chrono::steady_clock::time_point> mJobStarts;
+};
 
 /// <summary>
-/// Get compiled pixel shader 
+/// Shader after preprocess stage
 /// </summary>
-/// <returns></returns>
-template<typename T>
-inline T HotReloadableShaders::GetCompiledShaderByLocalName(const char* localName)
+struct PreprocessedShader
 {
-	auto res = reinterpret_cast<T>(mCompiledShadersA[localName]);
-	return res;
-}
+	// Preprocessed source (without comments, includes is resolved)
+	std::string text;
 
-/// <summary>
-/// Set custom callback, which called when shaders is compiled
-/// </summary>
-/// <param name="callback">Callbacl</param>
-inline void HotReloadableShaders::ActionIfCompiled(std::function<void()> callback)
+	// Hash of token stream, not depends from comments, whitespaces and #line directives
+	unsigned long long tokenHash;
+
+	// Included files and last time when they are changed (before reading)
+	std::map<std::string, unsigned long long> dependencies;
+};
+
+// Statistics of include cache
+struct ShaderIncludeCacheStatistics
 {
-	mCustomCallbackWhenShadersIsCompiled = callback;
-}
+	unsigned long long hits;
+	unsigned long long misses;
 
-/// <summary>
-/// Get FILETIME in unsigned long long
-/// </summary>
-/// <param name="ft">FILETIME data</param>
-/// <returns>unsigned long long</returns>
-inline unsigned long long FileTimeToUInt64(const FILETIME& ft) {
-	ULARGE_INTEGER uli;
-	uli.LowPart = ft.dwLowDateTime;
-	uli.HighPart = ft.dwHighDateTime;
-	return uli.QuadPart;
-}
+	// Bytes read from disk and bytes served from memory instead of disk
+	unsigned long long bytesRead;
+	unsigned long long bytesSaved;
+
+	size_t fileCount;
+	size_t cachedBytes;
+};
 
 /// <summary>
-/// Generate .cso files for compiled shaders
+/// In-memory cache of included files, shared by all compiles (thread-safe)
+/// Every file is read once and served to all compiles without copy,
+/// entry is replaced when file write time is changed or watcher reports it
 /// </summary>
-inline void HotReloadableShaders::GenerateCSO(ShaderInformation& info, void* buffer, int bufferSize)
+class ShaderIncludeCache
 {
-	// Prepare file name
-	std::string csoFile = info.hlslPath;
-	auto extOffet = csoFile.find(".hlsl");
-	csoFile.erase(extOffet);
-	csoFile.append(".cso");
+public:
+	typedef std::shared_ptr<const std::vector<unsigned char>> Buffer;
 
-	FILE* f = nullptr;
-	fopen_s(&f, csoFile.c_str(), "wb"); 
-	if (!f)
-	{
-		printf("Failed create .cso file for <%s>!\n", info.hlslPath);
-		return;
-	}
+	ShaderIncludeCache();
 
-	auto wroteBytes = fwrite(buffer, 1, bufferSize, f);
-	if (wroteBytes != bufferSize)
+	// Get file, read it only when it is not cached or changed
+	Buffer Load(const char* path, unsigned long long writeTime);
+
+	// Forget file, it is read again by next compile
+	void Invalidate(const char* path);
+
+	// Forget all files
+	void Clear();
+
+	// Hits, misses and saved bytes
+	ShaderIncludeCacheStatistics GetStatistics();
+
+private:
+	struct Entry
 	{
-		printf("Failed write in .cso file!");
-		fclose(f);
-		return;
-	}
+		unsigned long long writeTime;
+		Buffer buffer;
+	};
 
-	fclose(f);
-}
+	std::mutex mMutex;
+	std::map<std::string, Entry> mEntries;
+	ShaderIncludeCacheStatistics mStatistics;
+};
+
+// Process-wide include cache
+inline ShaderIncludeCache& GetShaderIncludeCache();
 
 /// <summary>
-/// Watch for files
+/// Include handler, resolves #include "file" relative to including file and records dependencies
 /// </summary>
-inline void HotReloadableShaders::StartWatch()
+class ShaderIncludeHandler : public ID3DInclude
 {
-	bIsCompiled = false;
-	mCompiledShaders.clear();
+public:
+	ShaderIncludeHandler(const char* hlslPath);
+	~ShaderIncludeHandler();
 
-	// Monitor every file that may change.
-	for (auto& info : mShadersInformation)
+	// Open included file
+	HRESULT STDMETHODCALLTYPE Open(D3D_INCLUDE_TYPE includeType, LPCSTR fileName, LPCVOID parentData, LPCVOID* data, UINT* bytes) override;
+
+	// Close included file
+	HRESULT STDMETHODCALLTYPE Close(LPCVOID data) override;
+
+	// Get included files
+	std::map<std::string, unsigned long long>& GetDependencies();
+
+private:
+	std::string mRootDirectory;
+
+	// Directory of every opened file, by data pointer
+	std::map<LPCVOID, std::string> mDirectories;
+
+	// Opened files, shared with include cache
+	std::vector<ShaderIncludeCache::Buffer> mBuffers;
+
+	std::map<std::string, unsigned long long> mDependencies;
+};
+
+/// <summary>
+/// Reflection metadata of compiled shader
+/// </summary>
+struct ShaderReflectionInfo
+{
+	unsigned int instructionCount;
+	unsigned int tempRegisterCount;
+	unsigned int textureInstructionCount;
+	unsigned int aluInstructionCount;
+	unsigned int constantBuffers;
+	unsigned int boundResources;
+	unsigned int inputParameters;
+	unsigned int outputParameters;
+};
+
+/// <summary>
+/// Cost of one compiled version (generation) of shader
+/// </summary>
+struct ShaderCostStatistics
+{
+	// Increased on every created shader of bundle
+	unsigned int generation;
+	ShaderCompileTier tier;
+
+	ShaderReflectionInfo reflection;
+	size_t bytecodeSize;
+};
+
+/// <summary>
+/// Cost budget of shader, 0 - no limit
+/// </summary>
+struct ShaderCostBudget
+{
+	unsigned int maxInstructionCount;
+	unsigned int maxTempRegisterCount;
+	unsigned int maxTextureInstructionCount;
+	unsigned int maxAluInstructionCount;
+	size_t maxBytecodeSize;
+};
+
+// Read cost of shader from bytecode
+inline bool GetShaderReflectionInfo(const void* bytecode, size_t bytecodeSize, ShaderReflectionInfo& reflectionInfo);
+
+// Remove debug info, reflection and private data from bytecode, shader is created from it as before
+inline bool StripShaderBytecode(const void* bytecode, size_t bytecodeSize, std::vector<unsigned char>& stripped);
+
+// Packed archive header
+struct ShaderArchiveHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int entryCount;
+	unsigned int dependencyCount;
+	unsigned long long entriesOffset;
+	unsigned long long dependenciesOffset;
+	unsigned long long stringsOffset;
+	unsigned long long stringsSize;
+};
+
+// File of archive entry: size and write time is checked first, content is hashed only if write time is other (fresh checkout)
+struct ShaderArchiveFile
+{
+	unsigned long long contentHash;
+	unsigned long long size;
+	unsigned long long writeTime;
+};
+
+// Packed archive entry, entries is sorted by name hash
+struct ShaderArchiveEntry
+{
+	unsigned long long nameHash;
+	unsigned long long tokenHash;
+	unsigned long long compileKey;
+	ShaderArchiveFile source; // .hlsl
+	unsigned long long bytecodeOffset;
+	unsigned int bytecodeSize;
+	unsigned int shaderType;
+	unsigned int nameOffset;
+	unsigned int dependencyIndex;
+	unsigned int dependencyCount;
+	unsigned int storedSize; // size in archive, equal to bytecodeSize if bytecode is not compressed
+	ShaderReflectionInfo reflection;
+};
+
+// File included by archive entry
+struct ShaderArchiveDependency
+{
+	ShaderArchiveFile file;
+	unsigned int pathOffset;
+	unsigned int flags;
+};
+
+// Path of dependency is relative to directory of .hlsl, so archive is valid in any checkout
+constexpr unsigned int ShaderArchiveDependencyRelative = 1;
+
+/// <summary>
+/// Writer of packed shader archive
+/// </summary>
+class ShaderArchiveWriter
+{
+public:
+	ShaderArchiveWriter();
+
+	// Strip debug info and reflection from bytecode, reflection metadata is kept in entry
+	void SetStripMode(bool isEnabled);
+
+	// Compress bytecode, default true
+	void SetCompression(bool isEnabled);
+
+	// Add compiled shader, source - hash of .hlsl content which is compiled, its size and write time
+	void Add(const ShaderInformation& info, const PreprocessedShader& preprocessed, const ShaderArchiveFile& source, const std::vector<unsigned char>& bytecode);
+
+	// Write archive in file
+	bool Write(const char* path);
+
+private:
+	struct PendingDependency
+	{
+		std::string path;
+		ShaderArchiveFile file;
+		unsigned int flags;
+	};
+
+	struct PendingEntry
+	{
+		std::string localName;
+		ShaderArchiveEntry entry;
+		std::vector<PendingDependency> dependencies;
+		std::vector<unsigned char> bytecode;
+	};
+	std::vector<PendingEntry> mEntries;
+
+	bool bIsStripMode;
+	bool bIsCompression;
+};
+
+/// <summary>
+/// Packed shader archive, memory-mapped read-only
+/// </summary>
+class ShaderArchive
+{
+public:
+	ShaderArchive();
+	~ShaderArchive();
+
+	// Open and map archive
+	bool Open(const char* path);
+
+	// Unmap archive
+	void Close();
+
+	// Is archive opened
+	bool IsOpen();
+
+	// Find entry by local name, O(log n)
+	const ShaderArchiveEntry* Find(const char* localName);
+
+	// Get bytecode of entry, compressed bytecode is decompressed in buffer
+	const void* GetBytecode(const ShaderArchiveEntry* entry, std::vector<unsigned char>& buffer);
+
+	// Get dependencies of entry
+	const ShaderArchiveDependency* GetDependencies(const ShaderArchiveEntry* entry);
+
+	// Get string from string table
+	const char* GetString(unsigned int offset);
+
+private:
+	HANDLE mFile;
+	HANDLE mMapping;
+	const unsigned char* mData;
+	unsigned long long mSize;
+
+	const ShaderArchiveHeader* mHeader;
+	const ShaderArchiveEntry* mEntries;
+	const ShaderArchiveDependency* mDependencies;
+	const char* mStrings;
+};
+
+/// <summary>
+/// Watcher of directories (ReadDirectoryChangesW)
+/// File which is replaced by rename (new file identity) or deleted and created again is reported by path,
+/// so watcher of HotReloadableShaders never loses it
+/// </summary>
+class ShaderDirectoryWatcher
+{
+public:
+	ShaderDirectoryWatcher();
+	~ShaderDirectoryWatcher();
+
+	// Watch directory of file, every directory is watched once
+	bool WatchFileDirectory(const char* filePath);
+
+	// Take paths (normalized) changed after last call
+	// false if events is lost (overflow or directory is removed), then all files must be checked
+	bool Poll(std::vector<std::string>& changedPaths);
+
+private:
+	struct WatchedDirectory
+	{
+		std::string path;
+		HANDLE handle;
+		OVERLAPPED overlapped;
+
+		// Notifications must be DWORD aligned
+		std::vector<DWORD> buffer;
+		bool isArmed;
+	};
+
+	// Open directory and start reading changes
+	bool Arm(WatchedDirectory& directory);
+
+	// Stop reading and close directory
+	void Disarm(WatchedDirectory& directory);
+
+	std::map<std::string, std::unique_ptr<WatchedDirectory>> mDirectories;
+};
+
+/// <summary>
+/// Counters of polling watcher
+/// </summary>
+struct ShaderPollingStatistics
+{
+	unsigned long long cycles;
+	unsigned long long listings;
+	// FindFirstFileEx, FindNextFile and FindClose calls
+	unsigned long long fileSystemCalls;
+	// Listings which is moved to next cycle by budget
+	unsigned long long deferredListings;
+	unsigned long long changes;
+	unsigned int directoryCount;
+	unsigned int hotDirectoryCount;
+};
+
+/// <summary>
+/// Polling watcher for file systems without change events (network shares, container mounts)
+/// Write times is taken on own thread by listing whole directories, directory with recently changed file is listed often,
+/// directory without changes is listed more and more rarely. Count of file system calls per cycle is limited
+/// </summary>
+class ShaderPollingWatcher
+{
+public:
+	ShaderPollingWatcher();
+	~ShaderPollingWatcher();
+
+	// Start thread: interval of hot directory, max interval of cold directory (ms), max file system calls per cycle
+	void Start(unsigned int hotInterval, unsigned int coldInterval, unsigned int callBudget);
+
+	// Stop thread
+	void Stop();
+
+	// Is thread running
+	bool IsRunning();
+
+	// Poll file, directory of new file is listed in next cycle
+	void WatchFile(const char* filePath);
+
+	// Last listed write time of file, false if file is not listed yet (then isExist is not valid)
+	bool GetWriteTime(const char* filePath, unsigned long long& time, bool& isExist);
+
+	// Take paths (normalized) changed after last call
+	void Poll(std::vector<std::string>& changedPaths);
+
+	// Counters
+	ShaderPollingStatistics GetStatistics();
+
+private:
+	struct PolledFile
+	{
+		unsigned long long writeTime;
+		bool isExist;
+		bool isListed;
+		std::chrono::steady_clock::time_point changeTime;
+	};
+
+	struct PolledDirectory
+	{
+		// By lowercase name
+		std::map<std::string, PolledFile> files;
+		std::chrono::steady_clock::time_point nextTime;
+		std::chrono::milliseconds interval;
+		bool isHot;
+	};
+
+	// Thread loop
+	void ThreadLoop();
+
+	// List directory, false if directory can't be read now
+	bool ListDirectory(const std::string& directory, std::map<std::string, std::pair<unsigned long long, bool>>& times, unsigned long long& calls);
+
+	// Normalized path, normalization is cached
+	const std::string& GetNormalizedPath(const char* filePath);
+
+	// Directory and name of normalized path
+	static bool SplitPath(const std::string& path, std::string& directory, std::string& name);
+
+	std::map<std::string, PolledDirectory> mDirectories;
+	std::map<std::string, std::string> mNormalizedPaths;
+	std::vector<std::string> mChangedPaths;
+	ShaderPollingStatistics mStatistics;
+
+	std::chrono::milliseconds mHotInterval;
+	std::chrono::milliseconds mColdInterval;
+	std::chrono::milliseconds mHotTime;
+	unsigned int mCallBudget;
+
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	std::thread mThread;
+	bool bIsStopping;
+};
+
+// Full lowercase path with backslashes, watcher compares paths in this form
+inline std::string NormalizeShaderPath(const char* path);
+
+// Progress of warm-up
+struct ShaderWarmUpProgress
+{
+	// Bundles of warm-ups started since last finished one
+	unsigned int total;
+	// Compiled, loaded from archive or failed
+	unsigned int finished;
+	// Failed to compile or file is missing
+	unsigned int failed;
+	// Time since warm-up is started
+	double milliseconds;
+};
+
+/// <summary>
+/// Storage of interned strings, every string is stored once
+/// Pointers are valid until Clear
+/// </summary>
+class ShaderStringArena
+{
+public:
+	ShaderStringArena() : mBlockUsed(0), mSize(0) {}
+	ShaderStringArena(const ShaderStringArena&) = delete;
+	ShaderStringArena& operator=(const ShaderStringArena&) = delete;
+
+	// Stored copy of string, nullptr for nullptr
+	const char* Intern(const char* string);
+	// Stored copy or nullptr if string is not interned
+	const char* Find(const char* string) const;
+	void Clear();
+
+	size_t GetCount() const { return mStrings.size(); }
+	// Bytes of stored strings
+	size_t GetSize() const { return mSize; }
+
+private:
+	static constexpr size_t BlockSize = 4096;
+
+	std::vector<std::unique_ptr<char[]>> mBlocks;
+	size_t mBlockUsed;
+	size_t mSize;
+	std::unordered_map<std::string_view, const char*> mStrings;
+};
+
+/// <summary>
+/// Immutable snapshot of compiled shaders
+/// Published by watcher thread (Start), read by any thread
+/// </summary>
+struct ShaderTableSnapshot
+{
+	struct Entry
+	{
+		// Shaders, one per device
+		std::vector<ID3D11Device*> devices;
+		std::vector<IUnknown*> shaders;
+
+		// Set by reader when shader is not compiled yet (lazy mode)
+		std::shared_ptr<std::atomic<bool>> isRequested;
+
+		// Used while shader is not compiled, can be nullptr
+		const Entry* fallback;
+	};
+	// By local name, any pointer can be used for search
+	std::map<std::string_view, Entry> entries;
+};
+
+// Messages of compile service protocol
+enum class ShaderServiceMessageType : unsigned int
+{
+	// Client -> service: watch and compile shader
+	// type, localName, hlslPath, entryPoint, shaderVersion, compile flags
+	Subscribe = 1,
+
+	// Service -> client: compile result
+	// localName, isSucceeded, tokenHash, bytecode, error message
+	Result = 2
+};
+
+// Header of every message in pipe
+struct ShaderServiceMessageHeader
+{
+	unsigned int magic;
+	unsigned int type;
+	unsigned int size;
+};
+
+/// <summary>
+/// Payload of compile service message
+/// </summary>
+class ShaderServiceMessage
+{
+public:
+	ShaderServiceMessage();
+
+	// Write values
+	void PutUInt(unsigned int value);
+	void PutUInt64(unsigned long long value);
+	void PutBytes(const void* data, size_t size);
+	void PutString(const char* value);
+
+	// Read values
+	bool GetUInt(unsigned int& value);
+	bool GetUInt64(unsigned long long& value);
+	bool GetBytes(std::vector<unsigned char>& data);
+	bool GetString(std::string& value);
+
+	// Header and values as one packet
+	std::vector<unsigned char> Pack(ShaderServiceMessageType type);
+
+	// Send message in pipe
+	bool Send(HANDLE pipe, ShaderServiceMessageType type);
+
+	std::vector<unsigned char> mData;
+	size_t mReadOffset;
+};
+
+/// <summary>
+/// Splits bytes from pipe to messages
+/// </summary>
+class ShaderServiceReceiver
+{
+public:
+	// Append bytes from pipe
+	void Append(const void* data, size_t size);
+
+	// Take next complete message
+	bool Next(ShaderServiceMessageType& type, ShaderServiceMessage& message);
+
+	// Is stream broken (wrong magic or too big message)
+	bool IsBroken();
+
+private:
+	std::vector<unsigned char> mBuffer;
+	bool bIsBroken = false;
+};
+
+/// <summary>
+/// Writes packets in overlapped pipe on own thread
+/// Caller never waits process on other side of pipe (service is busy or paused in debugger)
+/// </summary>
+class ShaderServiceWriter
+{
+public:
+	ShaderServiceWriter();
+	~ShaderServiceWriter();
+
+	// Start thread, pipe must be opened with FILE_FLAG_OVERLAPPED
+	void Start(HANDLE pipe);
+
+	// Stop thread, pending write is cancelled, not written packets is dropped
+	void Stop();
+
+	// Add packet in queue, false if pipe is broken
+	bool Queue(std::vector<unsigned char> packet);
+
+	// Is write failed
+	bool IsBroken();
+
+private:
+	// Thread loop
+	void WriterLoop();
+
+	HANDLE mPipe;
+	std::mutex mMutex;
+	std::condition_variable mChanged;
+	std::deque<std::vector<unsigned char>> mQueue;
+	std::atomic<bool> bIsBroken;
+	bool bIsStopping;
+	std::thread mThread;
+};
+
+class HotReloadableShaders
+{
+public:
+	HotReloadableShaders();
+	~HotReloadableShaders();
+
+	// Add new shader information
+	void AddNewBundle(ShaderInformation& information);
+
+	// Start watching
+	void Start();
+
+	// Bring system get Shader information data
+	ShaderInformation* GetShaderInformationByLocalName(const char* localName);
+
+	// Have the shaders been compiled
+	bool IsCompiled();
+
+	// Get compiled shaders type
+	std::vector<CompiledQueue> GetCompiledShadersType();
+
+	// Get compiled shader by local name
+	// device - for which device shader is needed, nullptr - device from ShaderInformation
+	// Thread-safe and wait-free, can be called while Start() is running (for example by threads which record deferred contexts)
+	// Shader is valid for frames of release latency (SetReleaseLatency), other methods must be called from thread of Start()
+	template<typename T>
+	T GetCompiledShaderByLocalName(const char* localName, ID3D11Device* device = nullptr);
+
+	// Get compiled shader with interface of stage, for example GetCompiledStageShader<HotReloadableShaderType::ComputeShader>("Blur")
+	template<HotReloadableShaderType Type>
+	typename ShaderStageTraits<Type>::Interface* GetCompiledStageShader(const char* localName, ID3D11Device* device = nullptr);
+
+	// Bind compiled shader of stage, false if it is not compiled
+	template<HotReloadableShaderType Type>
+	bool BindCompiledShader(const char* localName, ID3D11DeviceContext* context, ID3D11Device* device = nullptr);
+
+	// Add one more device for bundle
+	// Bytecode is compiled once and shaders is created for every device of bundle
+	bool AddBundleDevice(const char* localName, ShaderInformation::D3DRenderDevices devices);
+
+	// Set custom callback, which called when shaders is compiled
+	void ActionIfCompiled(std::function<void()> callback);
+
+	// Set directory for persisted bytecode cache
+	// Use same directory as ShaderBuilder, then first Start() is not compile anything
+	void SetCacheDirectory(const char* directory);
+
+	// Strip debug info and reflection from generated .cso, reflection metadata is written in .refl file
+	// Shaders in memory and in cache is not stripped
+	void SetStripMode(bool isEnabled);
+
+	// Load packed archive (made by ShaderBuilder -archive)
+	// Shaders which is not changed after archive is built, are created from it without compiling
+	bool LoadArchive(const char* path);
+
+	// Polling mode for file systems without change events (network shares, container mounts):
+	// write times is taken by own thread with directory listings, Start() makes no file system calls for watched files.
+	// Directory with file changed in last 10 seconds is listed every hotInterval ms, other directories up to every coldInterval ms
+	void SetPollingMode(bool isEnabled, unsigned int hotInterval = 100, unsigned int coldInterval = 2000, unsigned int callBudget = 256);
+
+	// Counters of polling mode
+	ShaderPollingStatistics GetPollingStatistics();
+
+	// Iteration mode: changed shader is compiled fast without optimization and swapped in,
+	// after file is quiet for optimizeDelay milliseconds, it is compiled with full optimization in background and swapped again
+	void SetIterationMode(bool isEnabled, unsigned int optimizeDelay = 1000);
+
+	// Get compile timings of bundle
+	bool GetCompileTimings(const char* localName, ShaderCompileTimings& timings);
+
+	// Replaced shaders is released after this count of frames (Start calls), so GPU can finish frames in flight
+	// Set it to swap chain latency, default 3
+	void SetReleaseLatency(unsigned int frames);
+
+	// Background compile workers: max count of compiles at once (0 - all hardware threads), OS priority and CPU affinity (0 - all CPUs).
+	// By default workers has THREAD_PRIORITY_BELOW_NORMAL, so they use only cores which is not used by game and editor threads
+	void SetCompileWorkers(unsigned int maxConcurrency, int priority = THREAD_PRIORITY_BELOW_NORMAL, unsigned long long affinityMask = 0);
+
+	// Report time of every frame: frame over budget halves count of compiles at once, frame under budget adds one,
+	// so hot reload runs at full speed when application is idle and backs off under load
+	void ReportFrameTime(double frameMilliseconds, double budgetMilliseconds);
+
+	// Queue depth and utilization of background compile workers
+	ShaderSchedulerStatistics GetCompileStatistics();
+
+	// Lazy mode: bundle is compiled on first use (GetCompiledShaderByLocalName from any thread) in background,
+	// fallback shader of stage is returned until it is published. Files is not watched before first use
+	void SetLazyMode(bool isEnabled);
+
+	// Fallback bundle of stage for lazy mode, it is always compiled
+	bool SetLazyFallback(HotReloadableShaderType type, const char* fallbackLocalName);
+
+	// Compile bundle now if it is not compiled (lazy mode), call from thread of Start()
+	bool ResolveShader(const char* localName);
+
+	// Add tag to bundle, bundles of tag is warmed up and waited together (for example "MainMenu", "Level1")
+	bool AddBundleTag(const char* localName, const char* tag);
+
+	// Warm-up: bundles of tag (nullptr - all bundles) which is not compiled, is compiled in parallel on all compile workers.
+	// Shaders is published by next Start() calls. Future is ready with true when all bundles of tag is compiled,
+	// with false when warm-up is finished and any bundle is failed
+	std::shared_future<bool> StartWarmUp(const char* tag = nullptr);
+
+	// Warm-up and wait for it, progress is called on this thread when any bundle is finished.
+	// Frame throttle (ReportFrameTime) is not used while waiting, call from thread of Start()
+	bool WarmUp(const char* tag = nullptr, const std::function<void(const ShaderWarmUpProgress&)>& progress = nullptr);
+
+	// Readiness of tag (nullptr - all bundles), can be waited by any thread (loading screen).
+	// Ready with true when all bundles of tag is compiled, tag without bundles is pending until bundle gets it
+	std::shared_future<bool> GetReadyFuture(const char* tag = nullptr);
+
+	// Progress of warm-ups started since last finished one
+	ShaderWarmUpProgress GetWarmUpProgress();
+
+	// Transactional mode: all bundles changed together (for example by shared header) is compiled in parallel
+	// and published together at frame boundary (Start) only if all of them is succeeded, otherwise last good set is kept
+	void SetTransactionalMode(bool isEnabled);
+
+	// Is .hlsl of bundle missing (deleted, moved), last shader is still used
+	bool IsBundleMissing(const char* localName);
+
+	// Bundles which .hlsl is missing, they is picked up again when file is back
+	std::vector<const char*> GetMissingBundles();
+
+	// Get cost history of bundle, last element is current shader
+	bool GetCostHistory(const char* localName, std::vector<ShaderCostStatistics>& history);
+
+	// Pin current cost of bundle as baseline, next versions is compared with it
+	bool PinCostBaseline(const char* localName);
+
+	// Set cost budget of bundle, warning is reported when optimized shader is over it
+	bool SetCostBudget(const char* localName, const ShaderCostBudget& budget);
+
+	// How many versions is kept in cost history of every bundle
+	void SetCostHistorySize(unsigned int size);
+
+	// Write cost of every generation in diagnostics, by default only changed cost against previous version of same tier is written
+	void SetCostReportOfEveryGeneration(bool isEnabled);
+
+	// Connect to out-of-process compile service (ShaderCompileDaemon)
+	// While connected, service watches and compiles files, and this instance only creates shaders
+	bool ConnectToCompileService(const char* pipeName = HOT_RELOADABLE_SHADERS_SERVICE_PIPE);
+
+	// Is connected to compile service
+	bool IsConnectedToCompileService();
+
+protected:
+
+	// Generate .cso files for compiled shaders
+	void GenerateCSO(ShaderInformation& info, void* buffer, int bufferSize);
+
+	// Watch for files
+	void StartWatch();
+
+	// Compile file
+	bool CompileFile(ShaderInformation& info);
+
+	// Create shader from packed archive
+	bool LoadFromArchive(ShaderInformation& info);
+
+	// Swap in optimized shaders and start optimized compilation of quiet files
+	void UpdateCompileTiers();
+
+	// Flag bundle which file is vanished or back, returns true if file is back
+	bool UpdateMissingBundle(unsigned int index, bool isMissing);
+
+	// Remember dependencies of failed compile, bundle is compiled again only when any of them is changed
+	void UpdateFailedDependencies(ShaderInformation& info, const std::map<std::string, unsigned long long>& dependencies);
+
+	// Watch directories of bundle file and included files
+	void WatchBundleDirectories(ShaderInformation& info);
+
+	// Compile change set in parallel, it is published by CommitShaderBatch
+	void StartShaderBatch(const std::vector<std::pair<ShaderInformation*, unsigned long long>>& changeSet, bool isTransactional);
+
+	// Write time from polling watcher in polling mode, otherwise from file system
+	bool GetWatchedFileWriteTime(const char* path, unsigned long long& time);
+
+	// Create scheduler of compile workers with current settings
+	ShaderJobScheduler* CreateCompileScheduler(unsigned int threadCount);
+
+	// Apply settings of compile workers
+	void ConfigureCompileScheduler(ShaderJobScheduler& scheduler);
+
+	// Compile queued warm-up bundles as change set, false if other change set is in flight
+	bool StartWarmUpBatch();
+
+	// Resolve readiness of tags
+	void UpdateWarmUp();
+
+	// Publish compiled change set: transactional - all bundles or nothing, otherwise every succeeded bundle
+	void CommitShaderBatch();
+
+	// Is shader of bundle created
+	bool HasCompiledShader(const char* localName);
+
+	// Is shader changed after preprocess, comments and whitespaces is not count
+	bool IsPreprocessedShaderChanged(ShaderInformation& info, const PreprocessedShader& preprocessed);
+
+	// Subscribe bundle to compile service
+	bool SubscribeToCompileService(ShaderInformation& info);
+
+	// Take compile results from service
+	void ReceiveCompileServiceResults();
+
+	// Close connection with service, local watching is used again
+	void DisconnectFromCompileService();
+
+	// Create shaders for every device of bundle and replace old shaders
+	bool CreateShader(ShaderInformation& info, const void* bytecode, size_t bytecodeSize, ShaderCompileTier tier = ShaderCompileTier::Optimized);
+
+	// Create shaders for every device of bundle, nothing is replaced
+	bool CreateShaderObjects(ShaderInformation& info, const void* bytecode, size_t bytecodeSize, std::vector<IUnknown*>& shaders);
+
+	// Publish new snapshot of shader table if it is changed, wait readers of old snapshot and delete it
+	void PublishShaderTable();
+
+	// Put replaced shader in retirement queue
+	void RetireShader(IUnknown* shader);
+
+	// Release retired shaders which GPU is not using, all of them if isAll
+	void ReleaseRetiredShaders(bool isAll = false);
+
+	// Replace old shaders of bundle by created
+	void PublishShaderObjects(ShaderInformation& info, std::vector<IUnknown*>& shaders, const void* bytecode, size_t bytecodeSize, ShaderCompileTier tier);
+
+	// Remember compiled source of created shader, write .cso
+	void ApplyCompiledShader(ShaderInformation& info, PreprocessedShader& preprocessed, const std::vector<unsigned char>& bytecode, ShaderCompileTier tier, double milliseconds);
+
+	// Add cost of created shader in history and report deltas
+	void RecordShaderCost(ShaderInformation& info, const void* bytecode, size_t bytecodeSize, ShaderCompileTier tier);
+
+
+private:
+	std::vector<CompiledQueue> mCompiledShaders;
+
+	// Runtime state of bundle (cold part, hot part is in columns of registry)
+	struct ShaderBundleState
+	{
+		// Devices for which shaders is created, first is from ShaderInformation
+		std::vector<ShaderInformation::D3DRenderDevices> devices;
+
+		// Create and bind functions of stage
+		const ShaderStageFunctions* stage;
+
+		// Tier and bytecode of created shaders, shader for added device is created from it
+		ShaderCompileTier tier;
+		std::vector<unsigned char> bytecode;
+
+		// Iteration tier: source for optimized compilation and time of last change
+		std::shared_ptr<PreprocessedShader> iterationSource;
+		std::chrono::steady_clock::time_point lastChangeTime;
+		bool isOptimizing;
+
+		ShaderCompileTimings timings;
+
+		// Cost of last versions, baseline and budget
+		std::deque<ShaderCostStatistics> costHistory;
+		ShaderCostStatistics costBaseline;
+		bool hasCostBaseline;
+		ShaderCostBudget costBudget;
+
+		// File is vanished (BundleMissing), last shader is kept
+		bool isMissingReported;
+		std::chrono::steady_clock::time_point missingTime;
+
+		// Compiled in failed change set, joins next change set
+		bool isBatchPending;
+
+		// Tags, strings is interned in mStrings
+		std::vector<const char*> tags;
+
+		// Queued or compiled by warm-up
+		bool isWarmUpPending;
+	};
+
+	static constexpr unsigned int InvalidBundleIndex = ~0u;
+
+	// Flags of bundle
+	// File is vanished, last shader is kept
+	static constexpr unsigned char BundleMissing = 1;
+	// Compiled without request (fallback of lazy mode)
+	static constexpr unsigned char BundleEager = 2;
+	// Created from archive, files is not checked until watcher reports change of them
+	static constexpr unsigned char BundleFromArchive = 4;
+	// Compiled by change set in flight or queued for warm-up, scan keeps notifications of it until it is published
+	static constexpr unsigned char BundleInFlight = 8;
+
+	// Bundles in structure of arrays, index of bundle is never changed
+	// Hot columns is read for every bundle by every watch scan, cold columns only for changed bundles
+	struct ShaderBundleRegistry
+	{
+		// Write time of .hlsl when bundle is compiled, 0 - not compiled yet
+		std::vector<unsigned long long> writeTimes;
+		// Hash of preprocessed token stream, from last successful compile
+		std::vector<unsigned long long> tokenHashes;
+		// Count of created versions
+		std::vector<unsigned int> generations;
+		// Shader of first device, nullptr - not compiled
+		std::vector<IUnknown*> primaryShaders;
+		// BundleMissing, BundleEager, BundleFromArchive, BundleInFlight
+		std::vector<unsigned char> flags;
+		// Lazy mode: shader is asked by any thread, compiled by next Start (shared with shader table)
+		std::vector<std::shared_ptr<std::atomic<bool>>> requests;
+		// Included files and last time when they are changed
+		std::vector<std::map<std::string, unsigned long long>> dependencies;
+		// Normalized paths of .hlsl and included files, notifications of watcher is compared with them
+		std::vector<std::vector<std::string>> watchedPaths;
+
+		// Information, strings is interned in mStrings
+		std::vector<ShaderInformation> informations;
+		std::vector<ShaderBundleState> states;
+		// Compiled shaders, one per device of bundle
+		std::vector<std::vector<IUnknown*>> shaders;
+
+		// Index of bundle by local name
+		std::unordered_map<std::string_view, unsigned int> indices;
+	};
+	ShaderBundleRegistry mBundles;
+
+	// Strings of bundles, caller's strings can be temporary
+	ShaderStringArena mStrings;
+
+	// Index of bundle in registry, InvalidBundleIndex if bundle is not added
+	unsigned int FindBundle(const char* localName);
+
+	// Bundle has tag, nullptr - any bundle
+	bool HasBundleTag(unsigned int index, const char* tag);
+
+	// Columns of added bundle
+	ShaderBundleState& GetBundleState(const char* localName);
+	unsigned long long& GetBundleWriteTime(const char* localName);
+	unsigned long long& GetBundleTokenHash(const char* localName);
+	std::map<std::string, unsigned long long>& GetBundleDependencies(const char* localName);
+
+	bool bIsCompiled;
+
+	std::function<void()> mCustomCallbackWhenShadersIsCompiled;
+
+	ShaderCache mShaderCache;
+	ShaderArchive mShaderArchive;
+
+	// Files which is validated against archive, by normalized path
+	// Entry is kept until watcher reports change of file, so shared header is checked once
+	struct ArchiveFileState
+	{
+		bool isExist;
+		bool isHashed;
+		unsigned long long size;
+		unsigned long long writeTime;
+		unsigned long long contentHash;
+	};
+	std::unordered_map<std::string, ArchiveFileState> mArchiveFiles;
+
+	// File has same content as when archive is built
+	bool IsSameArchiveFile(const std::string& path, const ShaderArchiveFile& file);
+
+	// Notifications of watcher which is not consumed by scan (bundle is in flight), merged in next Start()
+	std::vector<std::string> mNotifiedPaths;
+
+	// Pipe is overlapped, messages is written by writer thread and read without waiting
+	HANDLE mServicePipe;
+	ShaderServiceReceiver mServiceReceiver;
+	ShaderServiceWriter mServiceWriter;
+
+	// Iteration mode
+	bool bIsIterationMode;
+	unsigned int mOptimizeDelay;
+
+	unsigned int mCostHistorySize;
+	bool bIsCostReportOfEveryGeneration;
+
+	// Notifications of rename, delete and create, write times is still polled
+	ShaderDirectoryWatcher mDirectoryWatcher;
+
+	// Polling mode, used instead of directory watcher
+	bool bIsPollingMode;
+	ShaderPollingWatcher mPollingWatcher;
+
+	// Optimized tier results from background thread
+	struct OptimizedTierResult
+	{
+		const char* localName;
+		unsigned long long tokenHash;
+		bool isSucceeded;
+		std::vector<unsigned char> bytecode;
+		double milliseconds;
+	};
+	std::mutex mOptimizedResultsMutex;
+	std::vector<OptimizedTierResult> mOptimizedResults;
+
+	// One bundle of change set, compiled on worker thread
+	struct BatchCompile
+	{
+		ShaderInformation info;
+		unsigned long long writeTime;
+		unsigned long long previousHash;
+		ShaderCompileTier tier;
+		unsigned int flags;
+
+		bool isSucceeded;
+		// Token stream is changed, otherwise there is nothing to create
+		bool isChanged;
+		PreprocessedShader preprocessed;
+		std::vector<unsigned char> bytecode;
+		double milliseconds;
+	};
+
+	// Change set in flight
+	struct ShaderBatch
+	{
+		std::vector<BatchCompile> compiles;
+		std::atomic<unsigned int> remaining;
+		bool isTransactional;
+		bool isWarmUp;
+
+		// Signaled when any compile is finished, remaining is changed under mutex
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+
+	// Published shader table (RCU), readers is counted for two last epochs
+	std::atomic<ShaderTableSnapshot*> mShaderTable;
+	std::atomic<unsigned int> mShaderTableEpoch;
+	std::atomic<unsigned int> mShaderTableReaders[2];
+	bool bIsShaderTableChanged;
+
+	// Replaced shaders, released mReleaseLatency frames later
+	struct RetiredShader
+	{
+		unsigned long long frameIndex;
+		IUnknown* shader;
+	};
+	std::deque<RetiredShader> mRetiredShaders;
+	unsigned long long mFrameIndex;
+	unsigned int mReleaseLatency;
+
+	// Transactional mode
+	bool bIsTransactionalMode;
+
+	// Strip generated .cso
+	bool bIsStripMode;
+
+	// Lazy mode, local names of fallback bundles by stage
+	bool bIsLazyMode;
+	std::map<HotReloadableShaderType, const char*> mLazyFallbacks;
+	std::shared_ptr<ShaderBatch> mPendingBatch;
+
+	// Warm-up: queued bundles (index and write time), they is compiled when no change set is in flight
+	std::vector<std::pair<unsigned int, unsigned long long>> mWarmUpQueue;
+	ShaderWarmUpProgress mWarmUpProgress;
+	std::chrono::steady_clock::time_point mWarmUpStart;
+	bool bIsWarmUpReported;
+
+	// Readiness of tag ("" - all bundles), it is removed when future is resolved
+	struct TagReadiness
+	{
+		std::promise<bool> promise;
+		std::shared_future<bool> future;
+		// Warm-up of tag is started, failed bundles resolve it with false
+		bool isWarmingUp;
+
+		// Bundles of tag, created of them and queued by warm-up, updated by bundle events
+		unsigned int bundleCount;
+		unsigned int createdCount;
+		unsigned int pendingCount;
+	};
+	std::map<std::string, TagReadiness> mReadiness;
+
+	// Readiness of tag, it is created if it is not exist
+	TagReadiness& GetTagReadiness(const char* tag);
+
+	// Add to counters of tags of bundle
+	void CountTagReadiness(unsigned int index, int bundles, int created, int pending);
+
+	// Settings of compile workers, throttle is lowered under frame pressure
+	unsigned int mWorkerConcurrency;
+	int mWorkerPriority;
+	unsigned long long mWorkerAffinityMask;
+	unsigned int mWorkerThrottle;
+
+	// Background compilation, destroyed first
+	std::unique_ptr<ShaderJobScheduler> mBackgroundScheduler;
+	std::unique_ptr<ShaderJobScheduler> mBatchScheduler;
+};
+
+/// <summary>
+/// Constructor
+/// </summary>
+inline HotReloadableShaders::HotReloadableShaders()
+{
+	bIsCompiled = false;
+	mServicePipe = INVALID_HANDLE_VALUE;
+
+	bIsIterationMode = false;
+	mOptimizeDelay = 1000;
+
+	mCostHistorySize = 16;
+	bIsCostReportOfEveryGeneration = false;
+
+	bIsTransactionalMode = false;
+	bIsLazyMode = false;
+	bIsStripMode = false;
+	bIsPollingMode = false;
+
+	mWorkerConcurrency = 0;
+	mWorkerPriority = THREAD_PRIORITY_BELOW_NORMAL;
+	mWorkerAffinityMask = 0;
+	mWorkerThrottle = std::max(std::thread::hardware_concurrency(), 1u);
+
+	mFrameIndex = 0;
+	mReleaseLatency = 3;
+
+	mShaderTable = nullptr;
+	mShaderTableEpoch = 0;
+	mShaderTableReaders[0] = 0;
+	mShaderTableReaders[1] = 0;
+	bIsShaderTableChanged = false;
+
+	mWarmUpProgress = {};
+	bIsWarmUpReported = true;
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+inline HotReloadableShaders::~HotReloadableShaders()
+{
+	// Wait background compilation
+	mBackgroundScheduler.reset();
+	mBatchScheduler.reset();
+	mPendingBatch.reset();
+
+	// Waiters is released, shaders of tags will be never compiled
+	for (auto& readiness : mReadiness)
+		readiness.second.promise.set_value(false);
+	mReadiness.clear();
+
+	mCompiledShaders.clear();
+
+	DisconnectFromCompileService();
+	ReleaseRetiredShaders(true);
+
+	delete mShaderTable.exchange(nullptr);
+
+	for (auto& r : mBundles.shaders)
+	{
+		for (auto& shader : r)
+		{
+			if (shader)
+			{
+				shader->Release();
+				shader = nullptr;
+			}
+		}
+	}
+
+	mBundles = {};
+}
+
+/// <summary>
+/// Add new shader information
+/// Strings of information is copied, they can be freed after call
+/// </summary>
+/// <param name="information">Information with your shaders which is enable hot reload</param>
+inline void HotReloadableShaders::AddNewBundle(ShaderInformation& information)
+{
+	// Local name is key of bundle
+	if (!information.localName || !information.hlslPath || FindBundle(information.localName) != InvalidBundleIndex)
+	{
+		GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Error, information.localName, information.hlslPath, "Bundle is not added: local name is empty or is already used");
+		return;
+	}
+
+	ShaderInformation interned = information;
+	interned.localName = mStrings.Intern(information.localName);
+	interned.hlslPath = mStrings.Intern(information.hlslPath);
+	interned.entryPoint = mStrings.Intern(information.entryPoint);
+	interned.shaderVersion = mStrings.Intern(information.shaderVersion);
+
+	mBundles.indices[interned.localName] = (unsigned int)mBundles.informations.size();
+	mBundles.writeTimes.push_back(0);
+	mBundles.tokenHashes.push_back(0);
+	mBundles.generations.push_back(0);
+	mBundles.primaryShaders.push_back(nullptr);
+	mBundles.flags.push_back(0);
+	mBundles.requests.push_back(std::make_shared<std::atomic<bool>>(false));
+	mBundles.dependencies.push_back({});
+	mBundles.watchedPaths.push_back({ NormalizeShaderPath(interned.hlslPath) });
+	mBundles.informations.push_back(interned);
+	mBundles.shaders.push_back({});
+	mBundles.states.push_back({});
+	CountTagReadiness((unsigned int)mBundles.informations.size() - 1, 1, 0, 0);
+
+	auto& state = mBundles.states.back();
+	state.devices.push_back(interned.renderDevices);
+	state.stage = GetShaderStageFunctions(interned.localShaderType);
+	bIsShaderTableChanged = true;
+
+	// Lazy mode: directories is watched after first compile (bundle is not eager yet, SetLazyFallback is called after add)
+	if (!bIsLazyMode)
+		mDirectoryWatcher.WatchFileDirectory(interned.hlslPath);
+
+	if (IsConnectedToCompileService())
+		SubscribeToCompileService(mBundles.informations.back());
+}
+
+/// <summary>
+/// Start watching
+/// </summary>
+inline void HotReloadableShaders::Start()
+{
+	// Watching 
+	StartWatch();
+}
+
+/// <summary>
+/// Bring system get Shader information data
+/// </summary>
+/// <param name="localName">local name of shader information</param>
+/// <returns>Shader information</returns>
+inline ShaderInformation* HotReloadableShaders::GetShaderInformationByLocalName(const char* localName)
+{
+	auto index = FindBundle(localName);
+	return index != InvalidBundleIndex ? &mBundles.informations[index] : nullptr;
+}
+
+/// <summary>
+/// Have the shaders been compiled
+/// </summary>
+/// <returns></returns>
+inline bool HotReloadableShaders::IsCompiled()
+{
+	return bIsCompiled;
+}
+
+/// <summary>
+/// Get compiled shaders type
+/// </summary>
+/// <returns></returns>
+inline std::vector<CompiledQueue> HotReloadableShaders::GetCompiledShadersType()
+{
+	return mCompiledShaders;
+}
+
+/// <summary>
+/// Get compiled pixel shader 
+/// </summary>
+/// <param name="localName">local name of shader information</param>
+/// <param name="device">Device of shader, nullptr - device from ShaderInformation</param>
+/// <returns></returns>
+template<typename T>
+inline T HotReloadableShaders::GetCompiledShaderByLocalName(const char* localName, ID3D11Device* device)
+{
+	// Reader is counted in current epoch, snapshot is not deleted while it is counted
+	auto epoch = mShaderTableEpoch.load() & 1;
+	mShaderTableReaders[epoch]++;
+
+	auto findShader = [device](const ShaderTableSnapshot::Entry& entry) {
+		for (size_t i = 0; i < entry.shaders.size() && i < entry.devices.size(); i++)
+		{
+			if (!device || entry.devices[i] == device)
+				return entry.shaders[i];
+		}
+		return (IUnknown*)nullptr;
+	};
+
+	IUnknown* shader = nullptr;
+	auto table = mShaderTable.load();
+	if (table)
+	{
+		auto entry = table->entries.find(localName);
+		if (entry != table->entries.end())
+		{
+			shader = findShader(entry->second);
+
+			// First use, ask watcher to compile it and use fallback meanwhile
+			if (!shader)
+			{
+				if (entry->second.isRequested && !entry->second.isRequested->load(std::memory_order_relaxed))
+					entry->second.isRequested->store(true, std::memory_order_relaxed);
+				if (entry->second.fallback)
+					shader = findShader(*entry->second.fallback);
+			}
+		}
+	}
+
+	mShaderTableReaders[epoch]--;
+	return reinterpret_cast<T>(shader);
+}
+
+/// <summary>
+/// Get compiled shader with interface of stage
+/// </summary>
+/// <param name="localName">local name of shader information</param>
+/// <param name="device">Device, nullptr - device from ShaderInformation</param>
+/// <returns>Shader, nullptr if it is not compiled</returns>
+template<HotReloadableShaderType Type>
+inline typename ShaderStageTraits<Type>::Interface* HotReloadableShaders::GetCompiledStageShader(const char* localName, ID3D11Device* device)
+{
+	return GetCompiledShaderByLocalName<typename ShaderStageTraits<Type>::Interface*>(localName, device);
+}
+
+/// <summary>
+/// Bind compiled shader of stage
+/// </summary>
+/// <param name="localName">local name of shader information</param>
+/// <param name="context">Device context</param>
+/// <param name="device">Device of context, nullptr - device from ShaderInformation</param>
+/// <returns>false if shader is not compiled</returns>
+template<HotReloadableShaderType Type>
+inline bool HotReloadableShaders::BindCompiledShader(const char* localName, ID3D11DeviceContext* context, ID3D11Device* device)
+{
+	auto shader = GetCompiledStageShader<Type>(localName, device);
+	if (!shader || !context)
+		return false;
+
+	(context->*ShaderStageTraits<Type>::bind)(shader, nullptr, 0);
+	return true;
+}
+
+/// <summary>
+/// Add one more device for bundle
+/// If bundle is compiled, shader for new device is created at once from last published bytecode
+/// </summary>
+/// <param name="localName">local name of shader information</param>
+/// <param name="devices">Render devices</param>
+/// <returns>false if bundle is not found, device is already added or shader can't be created for it</returns>
+inline bool HotReloadableShaders::AddBundleDevice(const char* localName, ShaderInformation::D3DRenderDevices devices)
+{
+	auto info = GetShaderInformationByLocalName(localName);
+	if (!info || !devices.mRenderDevice)
+		return false;
+
+	auto& state = GetBundleState(info->localName);
+	for (auto& device : state.devices)
+	{
+		if (device.mRenderDevice == devices.mRenderDevice)
+			return false;
+	}
+	state.devices.push_back(devices);
+	bIsShaderTableChanged = true;
+
+	// Already compiled: shader is created only for new device from published bytecode, nothing is compiled
+	auto index = FindBundle(info->localName);
+	if (mBundles.primaryShaders[index] && !state.bytecode.empty())
+	{
+		ShaderTraceScope trace("CreateShader", info->localName);
+
+		IUnknown* shader = nullptr;
+		if (!state.stage || !state.stage->create(devices.mRenderDevice, state.bytecode.data(), state.bytecode.size(), &shader))
+		{
+			state.devices.pop_back();
+			GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Error, info->localName, info->hlslPath, "Shader is not created for added device");
+			return false;
+		}
+
+		mBundles.shaders[index].push_back(shader);
+		if (info->isAutomationBind && devices.mRenderDeviceContext)
+			state.stage->bind(devices.mRenderDeviceContext, shader);
+	}
+
+	PublishShaderTable();
+	return true;
+}
+
+/// <summary>
+/// Set custom callback, which called when shaders is compiled
+/// </summary>
+/// <param name="callback">Callbacl</param>
+inline void HotReloadableShaders::ActionIfCompiled(std::function<void()> callback)
+{
+	mCustomCallbackWhenShadersIsCompiled = callback;
+}
+
+/// <summary>
+/// Set directory for persisted bytecode cache
+/// </summary>
+/// <param name="directory">Cache directory</param>
+inline void HotReloadableShaders::SetCacheDirectory(const char* directory)
+{
+	mShaderCache.SetDirectory(directory);
+}
+
+/// <summary>
+/// Strip generated .cso, reflection metadata is written in .refl file
+/// </summary>
+/// <param name="isEnabled">Is enabled</param>
+inline void HotReloadableShaders::SetStripMode(bool isEnabled)
+{
+	bIsStripMode = isEnabled;
+}
+
+/// <summary>
+/// Load packed archive
+/// </summary>
+/// <param name="path">Path to archive</param>
+/// <returns>true if archive is opened</returns>
+inline bool HotReloadableShaders::LoadArchive(const char* path)
+{
+	return mShaderArchive.Open(path);
+}
+
+/// <summary>
+/// Set polling mode
+/// </summary>
+/// <param name="isEnabled">Is enabled</param>
+/// <param name="hotInterval">Interval of directory with recently changed file, ms</param>
+/// <param name="coldInterval">Max interval of directory without changes, ms</param>
+/// <param name="callBudget">Max count of file system calls per cycle of polling thread</param>
+inline void HotReloadableShaders::SetPollingMode(bool isEnabled, unsigned int hotInterval, unsigned int coldInterval, unsigned int callBudget)
+{
+	bIsPollingMode = isEnabled;
+	if (!isEnabled)
+	{
+		mPollingWatcher.Stop();
+		return;
+	}
+
+	mPollingWatcher.Start(hotInterval, coldInterval, callBudget);
+
+	// Compiled bundles is watched already
+	for (auto& info : mBundles.informations)
+	{
+		if (HasCompiledShader(info.localName))
+			WatchBundleDirectories(info);
+	}
+}
+
+/// <summary>
+/// Counters of polling mode
+/// </summary>
+/// <returns></returns>
+inline ShaderPollingStatistics HotReloadableShaders::GetPollingStatistics()
+{
+	return mPollingWatcher.GetStatistics();
+}
+
+/// <summary>
+/// Set iteration mode
+/// </summary>
+/// <param name="isEnabled">Compile changed shaders fast first</param>
+/// <param name="optimizeDelay">How long file must be quiet before optimized compilation, in milliseconds</param>
+inline void HotReloadableShaders::SetIterationMode(bool isEnabled, unsigned int optimizeDelay)
+{
+	bIsIterationMode = isEnabled;
+	mOptimizeDelay = optimizeDelay;
+}
+
+/// <summary>
+/// Get compile timings of bundle
+/// </summary>
+/// <param name="localName">local name of shader information</param>
+/// <param name="timings">out timings of last compilation of every tier</param>
+/// <returns>false if bundle is not found</returns>
+inline bool HotReloadableShaders::GetCompileTimings(const char* localName, ShaderCompileTimings& timings)
+{
+	auto info = GetShaderInformationByLocalName(localName);
+	if (!info)
+		return false;
+
+	timings = GetBundleState(info->localName).timings;
+	return true;
+}
+
+/// <summary>
+/// Replaced shaders is released after this count of frames
+/// </summary>
+/// <param name="frames">Frames (Start calls), 0 - released at next Start</param>
+inline void HotReloadableShaders::SetReleaseLatency(unsigned int frames)
+{
+	mReleaseLatency = frames;
+}
+
+/// <summary>
+/// Lazy mode, bundle is compiled on first use
+/// </summary>
+/// <param name="isEnabled">Is enabled</param>
+inline void HotReloadableShaders::SetLazyMode(bool isEnabled)
+{
+	bIsLazyMode = isEnabled;
+}
+
+/// <summary>
+/// Fallback bundle of stage for lazy mode
+/// Fallback must be compatible with shaders of stage (for example input signature of vertex shaders)
+/// </summary>
+/// <param name="type">Stage</param>
+/// <param name="fallbackLocalName">local name of fallback bundle, it is compiled without request</param>
+/// <returns>false if bundle is not found</returns>
+inline bool HotReloadableShaders::SetLazyFallback(HotReloadableShaderType type, const char* fallbackLocalName)
+{
+	auto info = GetShaderInformationByLocalName(fallbackLocalName);
+	if (!info || info->localShaderType != type)
+		return false;
+
+	mBundles.flags[FindBundle(info->localName)] |= BundleEager;
+	mLazyFallbacks[type] = info->localName;
+	bIsShaderTableChanged = true;
+	return true;
+}
+
+/// <summary>
+/// Transactional mode, change set is published at frame boundary only if all its bundles is succeeded
+/// </summary>
+/// <param name="isEnabled">Is enabled</param>
+inline void HotReloadableShaders::SetTransactionalMode(bool isEnabled)
+{
+	bIsTransactionalMode = isEnabled;
+}
+
+/// <summary>
+/// Is .hlsl of bundle missing
+/// </summary>
+/// <param name="localName">local name of shader information</param>
+/// <returns>true if file is missing, last shader is still used</returns>
+inline bool HotReloadableShaders::IsBundleMissing(const char* localName)
+{
+	auto info = GetShaderInformationByLocalName(localName);
+	if (!info)
+		return false;
+
+	return (mBundles.flags[FindBundle(info->localName)] & BundleMissing) != 0;
+}
+
+/// <summary>
+/// Bundles which .hlsl is missing
+/// </summary>
+/// <returns>Local names</returns>
+inline std::vector<const char*> HotReloadableShaders::GetMissingBundles()
+{
+	std::vector<const char*> bundles;
+	for (size_t index = 0; index < mBundles.informations.size(); index++)
+	{
+		if (mBundles.flags[index] & BundleMissing)
+			bundles.push_back(mBundles.informations[index].localName);
+	}
+	return bundles;
+}
+
+/// <summary>
+/// Get cost history of bundle
+/// </summary>
+/// <param name="localName">local name of shader information</param>
+/// <param name="history">out history, last element is current shader</param>
+/// <returns>false if bundle is not found</returns>
+inline bool HotReloadableShaders::GetCostHistory(const char* localName, std::vector<ShaderCostStatistics>& history)
+{
+	auto info = GetShaderInformationByLocalName(localName);
+	if (!info)
+		return false;
+
+	auto& costHistory = GetBundleState(info->localName).costHistory;
+	history.assign(costHistory.begin(), costHistory.end());
+	return true;
+}
+
+/// <summary>
+/// Pin current cost of bundle as baseline
+/// </summary>
+/// <param name="localName">local name of shader information</param>
+/// <returns>false if bundle is not found or not compiled yet</returns>
+inline bool HotReloadableShaders::PinCostBaseline(const char* localName)
+{
+	auto info = GetShaderInformationByLocalName(localName);
+	if (!info)
+		return false;
+
+	auto& state = GetBundleState(info->localName);
+	if (state.costHistory.empty())
+		return false;
+
+	state.costBaseline = state.costHistory.back();
+	state.hasCostBaseline = true;
+	return true;
+}
+
+/// <summary>
+/// Set cost budget of bundle
+/// </summary>
+/// <param name="localName">local name of shader information</param>
+/// <param name="budget">Budget, 0 - no limit</param>
+/// <returns>false if bundle is not found</returns>
+inline bool HotReloadableShaders::SetCostBudget(const char* localName, const ShaderCostBudget& budget)
+{
+	auto info = GetShaderInformationByLocalName(localName);
+	if (!info)
+		return false;
+
+	GetBundleState(info->localName).costBudget = budget;
+	return true;
+}
+
+/// <summary>
+/// How many versions is kept in cost history of every bundle
+/// </summary>
+/// <param name="size">History size, at least 1</param>
+inline void HotReloadableShaders::SetCostHistorySize(unsigned int size)
+{
+	mCostHistorySize = size ? size : 1;
+}
+
+/// <summary>
+/// Write cost of every generation in diagnostics
+/// Startup compiles, archive loads and optimized swaps is written too, so it is for cost investigation
+/// </summary>
+/// <param name="isEnabled">Is enabled, default false - only changed cost is written</param>
+inline void HotReloadableShaders::SetCostReportOfEveryGeneration(bool isEnabled)
+{
+	bIsCostReportOfEveryGeneration = isEnabled;
+}
+
+/// <summary>
+/// Connect to out-of-process compile service
+/// </summary>
+/// <param name="pipeName">Pipe name of service</param>
+/// <returns>true if connected</returns>
+inline bool HotReloadableShaders::ConnectToCompileService(const char* pipeName)
+{
+	DisconnectFromCompileService();
+
+	mServicePipe = CreateFileA(pipeName, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, NULL);
+	if (mServicePipe == INVALID_HANDLE_VALUE)
+		return false;
+
+	mServiceReceiver = {};
+	mServiceWriter.Start(mServicePipe);
+
+	// Service compiles and sends all shaders, which is already added
+	for (auto& info : mBundles.informations)
+	{
+		if (!SubscribeToCompileService(info))
+		{
+			DisconnectFromCompileService();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Is connected to compile service
+/// </summary>
+/// <returns></returns>
+inline bool HotReloadableShaders::IsConnectedToCompileService()
+{
+	return mServicePipe != INVALID_HANDLE_VALUE;
+}
+
+/// <summary>
+/// Get FILETIME in unsigned long long
+/// </summary>
+/// <param name="ft">FILETIME data</param>
+/// <returns>unsigned long long</returns>
+inline unsigned long long FileTimeToUInt64(const FILETIME& ft) {
+	ULARGE_INTEGER uli;
+	uli.LowPart = ft.dwLowDateTime;
+	uli.HighPart = ft.dwHighDateTime;
+	return uli.QuadPart;
+}
+
+/// <summary>
+/// Get size and last time when file is changed, file is not opened
+/// </summary>
+/// <param name="path">Path to file</param>
+/// <param name="size">out size</param>
+/// <param name="time">out time</param>
+/// <returns>false if file is not found</returns>
+inline bool GetFileSizeAndWriteTime(const char* path, unsigned long long& size, unsigned long long& time)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data = {};
+	if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data))
+		return false;
+
+	size = ((unsigned long long)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+	time = FileTimeToUInt64(data.ftLastWriteTime);
+	return true;
+}
+
+/// <summary>
+/// Get last time when file is changed
+/// </summary>
+/// <param name="path">Path to file</param>
+/// <param name="time">out time</param>
+/// <returns>false if file is not found</returns>
+inline bool GetFileWriteTime(const char* path, unsigned long long& time)
+{
+	WIN32_FIND_DATAA findData;
+	auto handle = FindFirstFileA(path, &findData);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		// Moved, Renamed, Deleted, or is replaced right now
+		return false;
+	}
+	FindClose(handle);
+
+	time = FileTimeToUInt64(findData.ftLastWriteTime);
+	return true;
+}
+
+/// <summary>
+/// Get path to .cso file for .hlsl file
+/// </summary>
+/// <param name="hlslPath">Path to .hlsl file</param>
+/// <returns>Path to .cso file</returns>
+inline std::string GetCSOPath(const char* hlslPath)
+{
+	std::string csoFile = hlslPath;
+	auto extOffset = csoFile.find_last_of('.');
+	auto slashOffset = csoFile.find_last_of("/\\");
+	if (extOffset != std::string::npos && (slashOffset == std::string::npos || extOffset > slashOffset))
+		csoFile.erase(extOffset);
+
+	csoFile.append(".cso");
+	return csoFile;
+}
+
+/// <summary>
+/// Write compiled bytecode in .cso file
+/// </summary>
+/// <param name="hlslPath">Path to .hlsl file</param>
+/// <param name="buffer">Bytecode</param>
+/// <param name="bufferSize">Bytecode size</param>
+/// <returns>true if file is written</returns>
+inline bool WriteCSOFile(const char* hlslPath, const void* buffer, size_t bufferSize)
+{
+	// Prepare file name
+	std::string csoFile = GetCSOPath(hlslPath);
+
+	FILE* f = nullptr;
+	fopen_s(&f, csoFile.c_str(), "wb");
+	if (!f)
+	{
+		GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Error, nullptr, csoFile.c_str(), "Failed create .cso file");
+		return false;
+	}
+
+	auto wroteBytes = fwrite(buffer, 1, bufferSize, f);
+	if (wroteBytes != bufferSize)
+	{
+		GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Error, nullptr, csoFile.c_str(), "Failed write in .cso file");
+		fclose(f);
+		return false;
+	}
+
+	fclose(f);
+	return true;
+}
+
+// Reflection file header
+struct ShaderReflectionFileHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int infoSize;
+	unsigned int reserved;
+};
+
+constexpr unsigned int ShaderReflectionFileMagic = 0x52535248; // "HRSR"
+constexpr unsigned int ShaderReflectionFileVersion = 1;
+
+/// <summary>
+/// Get path to .refl file for .hlsl file, reflection metadata of stripped .cso
+/// </summary>
+/// <param name="hlslPath">Path to .hlsl file</param>
+/// <returns>Path to .refl file</returns>
+inline std::string GetReflectionPath(const char* hlslPath)
+{
+	auto path = GetCSOPath(hlslPath);
+	path.erase(path.size() - 4);
+	path.append(".refl");
+	return path;
+}
+
+/// <summary>
+/// Write reflection metadata in .refl file
+/// </summary>
+/// <param name="hlslPath">Path to .hlsl file</param>
+/// <param name="reflectionInfo">Reflection metadata</param>
+/// <returns>true if file is written</returns>
+inline bool WriteReflectionFile(const char* hlslPath, const ShaderReflectionInfo& reflectionInfo)
+{
+	auto path = GetReflectionPath(hlslPath);
+
+	FILE* f = nullptr;
+	fopen_s(&f, path.c_str(), "wb");
+	if (!f)
+	{
+		GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Error, nullptr, path.c_str(), "Failed create .refl file");
+		return false;
+	}
+
+	ShaderReflectionFileHeader header = {};
+	header.magic = ShaderReflectionFileMagic;
+	header.version = ShaderReflectionFileVersion;
+	header.infoSize = sizeof(reflectionInfo);
+
+	bool isWritten = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(&reflectionInfo, sizeof(reflectionInfo), 1, f) == 1;
+	fclose(f);
+
+	if (!isWritten)
+		GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Error, nullptr, path.c_str(), "Failed write in .refl file");
+	return isWritten;
+}
+
+/// <summary>
+/// Read reflection metadata from .refl file
+/// </summary>
+/// <param name="hlslPath">Path to .hlsl file</param>
+/// <param name="reflectionInfo">out reflection metadata</param>
+/// <returns>true if file is read</returns>
+inline bool ReadReflectionFile(const char* hlslPath, ShaderReflectionInfo& reflectionInfo)
+{
+	FILE* f = nullptr;
+	fopen_s(&f, GetReflectionPath(hlslPath).c_str(), "rb");
+	if (!f)
+		return false;
+
+	ShaderReflectionFileHeader header = {};
+	bool isRead = fread(&header, sizeof(header), 1, f) == 1 && header.magic == ShaderReflectionFileMagic &&
+		header.version == ShaderReflectionFileVersion && header.infoSize == sizeof(reflectionInfo) &&
+		fread(&reflectionInfo, sizeof(reflectionInfo), 1, f) == 1;
+	fclose(f);
+
+	return isRead;
+}
+
+/// <summary>
+/// Write stripped bytecode in .cso file and its reflection metadata in .refl file
+/// </summary>
+/// <param name="hlslPath">Path to .hlsl file</param>
+/// <param name="buffer">Bytecode (not stripped)</param>
+/// <param name="bufferSize">Bytecode size</param>
+/// <returns>true if files is written</returns>
+inline bool WriteStrippedCSOFile(const char* hlslPath, const void* buffer, size_t bufferSize)
+{
+	ShaderReflectionInfo reflectionInfo = {};
+	std::vector<unsigned char> stripped;
+	if (!GetShaderReflectionInfo(buffer, bufferSize, reflectionInfo) || !StripShaderBytecode(buffer, bufferSize, stripped))
+		return WriteCSOFile(hlslPath, buffer, bufferSize);
+
+	return WriteReflectionFile(hlslPath, reflectionInfo) && WriteCSOFile(hlslPath, stripped.data(), stripped.size());
+}
+
+/// <summary>
+/// Generate .cso files for compiled shaders
+/// </summary>
+inline void HotReloadableShaders::GenerateCSO(ShaderInformation& info, void* buffer, int bufferSize)
+{
+	ShaderTraceScope trace("WriteCSO", info.localName);
+	if (bIsStripMode)
+		WriteStrippedCSOFile(info.hlslPath, buffer, (size_t)bufferSize);
+	else
+		WriteCSOFile(info.hlslPath, buffer, (size_t)bufferSize);
+}
+
+/// <summary>
+/// Watch for files
+/// </summary>
+inline void HotReloadableShaders::StartWatch()
+{
+	bIsCompiled = false;
+	mCompiledShaders.clear();
+
+	// Start is frame boundary
+	mFrameIndex++;
+	ReleaseRetiredShaders();
+
+	// Files is watched and compiled by service
+	if (IsConnectedToCompileService())
+	{
+		ReceiveCompileServiceResults();
+		PublishShaderTable();
+		UpdateWarmUp();
+
+		if (mCustomCallbackWhenShadersIsCompiled && IsCompiled())
+		{
+			ShaderTraceScope trace("Callback");
+			mCustomCallbackWhenShadersIsCompiled();
+		}
+		return;
+	}
+
+	// Publish change set which is compiled in background
+	// Bundles of it is not checked while it is compiled, other bundles is scanned as usual
+	bool isBatchCompiling = false;
+	if (mPendingBatch)
+	{
+		if (mPendingBatch->remaining == 0)
+			CommitShaderBatch();
+		else
+			isBatchCompiling = true;
+	}
+
+	// Queued warm-up is started as soon as no change set is in flight
+	if (!isBatchCompiling && StartWarmUpBatch())
+		isBatchCompiling = true;
+
+	// Bundles changed in this call (transactional mode)
+	std::vector<std::pair<ShaderInformation*, unsigned long long>> changeSet;
+
+	// Time of included files, every file is checked once per call
+	std::map<std::string, unsigned long long> dependencyTimes;
+
+	// Renamed, deleted and created files, times of them can be same as before
+	std::vector<std::string> changedPaths;
+	bool isEverythingChanged = false;
+	if (bIsPollingMode)
+		mPollingWatcher.Poll(changedPaths);
+	else
+		isEverythingChanged = !mDirectoryWatcher.Poll(changedPaths);
+
+	// Included file with same write time (renamed over old one) must be read again
+	for (auto& path : changedPaths)
+	{
+		GetShaderIncludeCache().Invalidate(path.c_str());
+		mArchiveFiles.erase(path);
+	}
+	if (isEverythingChanged)
+	{
+		GetShaderIncludeCache().Clear();
+		mArchiveFiles.clear();
+	}
+
+	// Watcher queue is drained, notifications of bundles which was in flight is kept from last call
+	changedPaths.insert(changedPaths.end(), mNotifiedPaths.begin(), mNotifiedPaths.end());
+	mNotifiedPaths.clear();
+	std::sort(changedPaths.begin(), changedPaths.end());
+	changedPaths.erase(std::unique(changedPaths.begin(), changedPaths.end()), changedPaths.end());
+
+	// Paths of bundle is normalized when it is watched, scan only compares them
+	auto isNotified = [&](unsigned int index) {
+		if (isEverythingChanged)
+			return true;
+		if (changedPaths.empty())
+			return false;
+
+		auto& paths = mBundles.watchedPaths[index];
+		return std::any_of(paths.begin(), paths.end(), [&](const std::string& path) { return std::binary_search(changedPaths.begin(), changedPaths.end(), path); });
+	};
+
+	// Bundle is not compiled now, its notifications is kept for next call (rename with same time is not found by time)
+	auto keepNotified = [&](unsigned int index) {
+		for (auto& path : mBundles.watchedPaths[index])
+		{
+			if (isEverythingChanged || std::binary_search(changedPaths.begin(), changedPaths.end(), path))
+				mNotifiedPaths.push_back(path);
+		}
+	};
+
+	// Changed bundles of this call is one pass of diagnostics, same error from shared header is written once
+	bool isPassStarted = false;
+	auto beginPass = [&isPassStarted]() {
+		if (!isPassStarted)
+			GetShaderDiagnostics().BeginPass();
+		isPassStarted = true;
+	};
+
+	// Scan is recorded with compilation of changed files inside it
+	{
+		ShaderTraceScope trace("WatchScan");
+
+		// Monitor every file that may change.
+		// Columns is walked by index, unchanged bundle reads only hot columns and path of information
+		for (unsigned int index = 0; index < (unsigned int)mBundles.informations.size(); index++)
+		{
+			auto& info = mBundles.informations[index];
+			auto& flags = mBundles.flags[index];
+			auto& dependencies = mBundles.dependencies[index];
+
+			// Change set in flight publishes it, change after its read is found by next call
+			if (flags & BundleInFlight)
+			{
+				keepNotified(index);
+				continue;
+			}
+
+			// Lazy mode: bundle is not watched and not compiled until it is used
+			bool isFirstUse = false;
+			if (bIsLazyMode && !(flags & BundleEager) && !mBundles.primaryShaders[index])
+			{
+				if (!mBundles.requests[index]->load(std::memory_order_relaxed))
+					continue;
+				isFirstUse = true;
+			}
+
+			// Created from archive: files is not touched until watcher reports change of source or included file
+			bool isArchiveChanged = false;
+			if (flags & BundleFromArchive)
+			{
+				isArchiveChanged = isNotified(index);
+				if (!isArchiveChanged)
+					continue;
+				flags &= ~BundleFromArchive;
+			}
+
+			// First time, try take it from archive
+			if (mBundles.writeTimes[index] == 0 && !mBundles.primaryShaders[index] && LoadFromArchive(info))
+			{
+				WatchBundleDirectories(info);
+				continue;
+			}
+
+			unsigned long long time = 0;
+			if (!GetWatchedFileWriteTime(info.hlslPath, time))
+			{
+				UpdateMissingBundle(index, true);
+				continue;
+			}
+
+			// File is back, compile it whatever time it has
+			bool isBack = UpdateMissingBundle(index, false);
+
+			bool isChanged = isArchiveChanged || isBack || mBundles.writeTimes[index] != time || isNotified(index);
+
+			// Included files
+			for (auto& dependency : dependencies)
+			{
+				if (isChanged)
+					break;
+
+				auto dependencyTime = dependencyTimes.find(dependency.first);
+				if (dependencyTime == dependencyTimes.end())
+				{
+					unsigned long long currentTime = 0;
+					GetWatchedFileWriteTime(dependency.first.c_str(), currentTime);
+					dependencyTime = dependencyTimes.emplace(dependency.first, currentTime).first;
+				}
+
+				isChanged = dependencyTime->second != dependency.second;
+			}
+
+			// Other change set is in flight, bundle joins change set of next call
+			if (isChanged && (bIsTransactionalMode || isFirstUse) && isBatchCompiling)
+			{
+				keepNotified(index);
+				continue;
+			}
+
+			if (isChanged)
+				beginPass();
+
+			if (isChanged && (bIsTransactionalMode || isFirstUse))
+			{
+				// Time is updated when change set is published
+				// First use is compiled in background, fallback shader is used until it is published
+				changeSet.push_back({ &info, time });
+			}
+			else if (isChanged)
+			{
+				CompileFile(info);
+				WatchBundleDirectories(info);
+
+				// Update last time 
+				mBundles.writeTimes[index] = time;
+			}
+		}
+	}
+
+	// Bundles from failed change set is published only together with new changes
+	if (!changeSet.empty())
+	{
+		for (size_t index = 0; index < mBundles.informations.size(); index++)
+		{
+			auto& info = mBundles.informations[index];
+			auto isInChangeSet = std::any_of(changeSet.begin(), changeSet.end(), [&](const std::pair<ShaderInformation*, unsigned long long>& change) { return change.first == &info; });
+			if (mBundles.states[index].isBatchPending && !isInChangeSet)
+				changeSet.push_back({ &info, mBundles.writeTimes[index] });
+		}
+
+		StartShaderBatch(changeSet, bIsTransactionalMode);
+	}
+
+	UpdateCompileTiers();
+	PublishShaderTable();
+	UpdateWarmUp();
+
+	// if callback is set
+	// Call it
+	if (mCustomCallbackWhenShadersIsCompiled && IsCompiled())
+	{
+		ShaderTraceScope trace("Callback");
+		mCustomCallbackWhenShadersIsCompiled();
+	}
+}
+
+/// <summary>
+/// Compile bundle now if it is not compiled
+/// </summary>
+/// <param name="localName">local name of shader information</param>
+/// <returns>true if shader is compiled</returns>
+inline bool HotReloadableShaders::ResolveShader(const char* localName)
+{
+	auto info = GetShaderInformationByLocalName(localName);
+	if (!info)
+		return false;
+
+	mBundles.requests[FindBundle(info->localName)]->store(true);
+	if (HasCompiledShader(info->localName))
+		return true;
+
+	unsigned long long time = 0;
+	if (!GetFileWriteTime(info->hlslPath, time))
+		return false;
+
+	if (!LoadFromArchive(*info))
+	{
+		GetShaderDiagnostics().BeginPass();
+		CompileFile(*info);
+		GetBundleWriteTime(info->localName) = time;
+	}
+	WatchBundleDirectories(*info);
+	PublishShaderTable();
+
+	return HasCompiledShader(info->localName);
+}
+
+/// <summary>
+/// Add tag to bundle
+/// </summary>
+/// <param name="localName">local name of shader information</param>
+/// <param name="tag">Tag, string is copied</param>
+/// <returns>false if bundle is not added</returns>
+inline bool HotReloadableShaders::AddBundleTag(const char* localName, const char* tag)
+{
+	auto index = FindBundle(localName);
+	if (index == InvalidBundleIndex || !tag)
+		return false;
+
+	auto& tags = mBundles.states[index].tags;
+	auto interned = mStrings.Intern(tag);
+	if (std::find(tags.begin(), tags.end(), interned) != tags.end())
+		return true;
+	tags.push_back(interned);
+
+	// Readiness of tag is already asked
+	auto readiness = mReadiness.find(interned);
+	if (readiness != mReadiness.end())
+	{
+		readiness->second.bundleCount++;
+		readiness->second.createdCount += mBundles.primaryShaders[index] ? 1 : 0;
+		readiness->second.pendingCount += mBundles.states[index].isWarmUpPending ? 1 : 0;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Start warm-up of bundles of tag
+/// Bundles from archive is created at once, other bundles is compiled in parallel as one change set,
+/// so wall time is bounded by longest shader and not by sum of them
+/// </summary>
+/// <param name="tag">Tag of bundles, nullptr - all bundles</param>
+/// <returns>Readiness of tag</returns>
+inline std::shared_future<bool> HotReloadableShaders::StartWarmUp(const char* tag)
+{
+	// Files is compiled by service, readiness is resolved when results is received
+	if (IsConnectedToCompileService())
+		return GetReadyFuture(tag);
+
+	ShaderTraceScope trace("WarmUp");
+	GetShaderDiagnostics().BeginPass();
+
+	if (mWarmUpProgress.finished >= mWarmUpProgress.total)
+	{
+		mWarmUpProgress = {};
+		mWarmUpStart = std::chrono::steady_clock::now();
+		bIsWarmUpReported = false;
+	}
+
+	for (unsigned int index = 0; index < mBundles.informations.size(); index++)
+	{
+		auto& info = mBundles.informations[index];
+		auto& state = mBundles.states[index];
+		if (!HasBundleTag(index, tag) || mBundles.primaryShaders[index] || state.isWarmUpPending)
+			continue;
+
+		// Bundle is used (lazy mode)
+		mWarmUpProgress.total++;
+		mBundles.requests[index]->store(true);
+
+		unsigned long long time = 0;
+		if (!GetWatchedFileWriteTime(info.hlslPath, time))
+		{
+			UpdateMissingBundle(index, true);
+			mWarmUpProgress.finished++;
+			mWarmUpProgress.failed++;
+			continue;
+		}
+
+		if (LoadFromArchive(info))
+		{
+			WatchBundleDirectories(info);
+			mWarmUpProgress.finished++;
+			continue;
+		}
+
+		state.isWarmUpPending = true;
+		CountTagReadiness(index, 0, 0, 1);
+		mBundles.flags[index] |= BundleInFlight;
+		mWarmUpQueue.push_back({ index, time });
+	}
+
+	// Workers start at once, shaders is created when change set is published
+	StartWarmUpBatch();
+	PublishShaderTable();
+
+	auto& readiness = GetTagReadiness(tag);
+	readiness.isWarmingUp = true;
+	auto future = readiness.future;
+
+	UpdateWarmUp();
+	return future;
+}
+
+/// <summary>
+/// Warm-up bundles of tag and wait until they is published
+/// </summary>
+/// <param name="tag">Tag of bundles, nullptr - all bundles</param>
+/// <param name="progress">Called when any bundle is finished, can be nullptr</param>
+/// <returns>true if all bundles of tag is compiled</returns>
+inline bool HotReloadableShaders::WarmUp(const char* tag, const std::function<void(const ShaderWarmUpProgress&)>& progress)
+{
+	auto future = StartWarmUp(tag);
+
+	// Nothing is rendered while waiting, frame throttle is lifted
+	if (mBatchScheduler)
+		mBatchScheduler->SetThrottle(std::max(std::thread::hardware_concurrency(), 1u));
+
+	unsigned int reported = ~0u;
+	while (mPendingBatch)
+	{
+		auto current = GetWarmUpProgress();
+		if (progress && current.finished != reported)
+		{
+			reported = current.finished;
+			progress(current);
+		}
+
+		// Wait until any compile is finished, progress is reported for every bundle
+		auto batch = mPendingBatch;
+		if (batch->remaining != 0)
+		{
+			std::unique_lock<std::mutex> lock(batch->mutex);
+			auto remaining = batch->remaining.load();
+			batch->finished.wait(lock, [&]() { return batch->remaining != remaining; });
+			continue;
+		}
+
+		CommitShaderBatch();
+		StartWarmUpBatch();
+	}
+
+	if (mBatchScheduler)
+		mBatchScheduler->SetThrottle(mWorkerThrottle);
+
+	PublishShaderTable();
+	UpdateWarmUp();
+
+	auto current = GetWarmUpProgress();
+	if (progress && current.finished != reported)
+		progress(current);
+
+	// Service results is received only by Start()
+	return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready && future.get();
+}
+
+/// <summary>
+/// Readiness of tag
+/// </summary>
+/// <param name="tag">Tag of bundles, nullptr - all bundles</param>
+/// <returns>Future which is ready with true when all bundles of tag is compiled</returns>
+inline std::shared_future<bool> HotReloadableShaders::GetReadyFuture(const char* tag)
+{
+	auto future = GetTagReadiness(tag).future;
+	UpdateWarmUp();
+	return future;
+}
+
+/// <summary>
+/// Progress of warm-ups started since last finished one
+/// Compiles which is finished by workers, but not published yet, is counted too
+/// </summary>
+/// <returns>Progress</returns>
+inline ShaderWarmUpProgress HotReloadableShaders::GetWarmUpProgress()
+{
+	auto progress = mWarmUpProgress;
+	if (mPendingBatch && mPendingBatch->isWarmUp)
+		progress.finished += (unsigned int)mPendingBatch->compiles.size() - mPendingBatch->remaining;
+
+	if (progress.finished < progress.total)
+		progress.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mWarmUpStart).count();
+
+	return progress;
+}
+
+/// <summary>
+/// Compile queued warm-up bundles as one change set, every succeeded bundle is published
+/// </summary>
+/// <returns>false if queue is empty or other change set is in flight</returns>
+inline bool HotReloadableShaders::StartWarmUpBatch()
+{
+	if (mWarmUpQueue.empty() || mPendingBatch)
+		return false;
+
+	// Workers take jobs in order, larger files is started first,
+	// so longest compile is not started last (size of .hlsl is estimate of compile time)
+	std::vector<std::pair<unsigned long long, size_t>> order;
+	for (size_t i = 0; i < mWarmUpQueue.size(); i++)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA data = {};
+		unsigned long long size = 0;
+		if (GetFileAttributesExA(mBundles.informations[mWarmUpQueue[i].first].hlslPath, GetFileExInfoStandard, &data))
+			size = ((unsigned long long)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+		order.push_back({ size, i });
+	}
+	std::stable_sort(order.begin(), order.end(), [](const std::pair<unsigned long long, size_t>& a, const std::pair<unsigned long long, size_t>& b) { return a.first > b.first; });
+
+	std::vector<std::pair<ShaderInformation*, unsigned long long>> changeSet;
+	for (auto& item : order)
+	{
+		auto& queued = mWarmUpQueue[item.second];
+		changeSet.push_back({ &mBundles.informations[queued.first], queued.second });
+	}
+	mWarmUpQueue.clear();
+
+	StartShaderBatch(changeSet, false);
+	mPendingBatch->isWarmUp = true;
+	return true;
+}
+
+/// <summary>
+/// Resolve readiness of tags and report finished warm-up
+/// </summary>
+inline void HotReloadableShaders::UpdateWarmUp()
+{
+	if (!bIsWarmUpReported && mWarmUpProgress.total && mWarmUpProgress.finished >= mWarmUpProgress.total)
+	{
+		bIsWarmUpReported = true;
+		mWarmUpProgress.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mWarmUpStart).count();
+
+		char message[256] = {};
+		sprintf_s(message, sizeof(message), "Warm-up is finished: %u bundles in %.2f ms, %u is failed",
+			mWarmUpProgress.total, mWarmUpProgress.milliseconds, mWarmUpProgress.failed);
+		GetShaderDiagnostics().Report(mWarmUpProgress.failed ? ShaderDiagnosticSeverity::Warning : ShaderDiagnosticSeverity::Info, nullptr, nullptr, message);
+	}
+
+	// Counters is updated by bundle events, bundles is not walked
+	for (auto readiness = mReadiness.begin(); readiness != mReadiness.end();)
+	{
+		auto& counters = readiness->second;
+		bool isReady = counters.createdCount == counters.bundleCount;
+		bool isPending = counters.pendingCount != 0;
+		bool hasBundles = counters.bundleCount != 0;
+
+		// Tag is unknown or is asked before AddBundleTag, it is not ready until bundles get it.
+		// Warm-up of it has nothing to compile, so it is failed
+		if (!hasBundles)
+		{
+			if (!readiness->second.isWarmingUp)
+			{
+				++readiness;
+				continue;
+			}
+
+			GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Warning, nullptr, nullptr,
+				(std::string("Warm-up is failed: no bundles with tag '") + readiness->first + "'").c_str());
+			isReady = false;
+		}
+
+		// Warm-up is finished, but not every bundle is compiled
+		bool isFailed = !isReady && !isPending && readiness->second.isWarmingUp;
+		if (!isReady && !isFailed)
+		{
+			++readiness;
+			continue;
+		}
+
+		readiness->second.promise.set_value(isReady);
+		readiness = mReadiness.erase(readiness);
+	}
+}
+
+/// <summary>
+/// Readiness of tag, it is created if it is not exist
+/// </summary>
+/// <param name="tag">Tag of bundles, nullptr - all bundles</param>
+/// <returns></returns>
+inline HotReloadableShaders::TagReadiness& HotReloadableShaders::GetTagReadiness(const char* tag)
+{
+	auto& readiness = mReadiness[tag ? tag : ""];
+	if (!readiness.future.valid())
+	{
+		readiness.future = readiness.promise.get_future().share();
+		readiness.isWarmingUp = false;
+
+		// Bundles is walked once, then counters is updated by events
+		readiness.bundleCount = 0;
+		readiness.createdCount = 0;
+		readiness.pendingCount = 0;
+		for (unsigned int index = 0; index < mBundles.informations.size(); index++)
+		{
+			if (!HasBundleTag(index, tag))
+				continue;
+
+			readiness.bundleCount++;
+			readiness.createdCount += mBundles.primaryShaders[index] ? 1 : 0;
+			readiness.pendingCount += mBundles.states[index].isWarmUpPending ? 1 : 0;
+		}
+	}
+	return readiness;
+}
+
+/// <summary>
+/// Add to counters of readiness of tags which bundle has
+/// </summary>
+/// <param name="index">Index of bundle</param>
+/// <param name="bundles">Added bundles</param>
+/// <param name="created">Added created bundles</param>
+/// <param name="pending">Added bundles queued by warm-up</param>
+inline void HotReloadableShaders::CountTagReadiness(unsigned int index, int bundles, int created, int pending)
+{
+	for (auto& readiness : mReadiness)
+	{
+		if (!HasBundleTag(index, readiness.first.empty() ? nullptr : readiness.first.c_str()))
+			continue;
+
+		readiness.second.bundleCount += bundles;
+		readiness.second.createdCount += created;
+		readiness.second.pendingCount += pending;
+	}
+}
+
+/// <summary>
+/// Read file 
+/// </summary>
+/// <param name="filename">Path to file</param>
+/// <param name="buffer">out buffer</param>
+/// <returns></returns>
+inline bool ReadFile(const char* filename, std::vector<unsigned char>& buffer)
+{
+	// sometimes text editors may not have time to update the file,
+	// in which case the buffer will be empty. 
+	// Try to read it again.
+	int maxAttempts = 5;
+	int attempts = 0;
+	for (int i = 0; i < maxAttempts; i++)
+	{
+		// Open file
+		HANDLE hFile = CreateFileA(
+			filename,
+			GENERIC_READ,
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, // set all mode, because all most code editors opened file with all mode.
+			NULL,
+			OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL,
+			NULL
+		);
+
+		if (hFile == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(hFile, &fileSize)) {
+			CloseHandle(hFile);
+			return false;
+		}
+
+		// if size = 0;
+		// the file did not have time to update
+		if (fileSize.QuadPart == 0)
+		{
+			attempts++;
+			continue;
+		}
+
+		buffer.resize(fileSize.QuadPart);
+		DWORD bytesRead = 0;
+		if (!ReadFile(hFile, buffer.data(), (DWORD)fileSize.QuadPart, &bytesRead, NULL)) {
+			CloseHandle(hFile);
+			return false;
+		}
+
+		CloseHandle(hFile);
+
+		return true;
+	}
+
+	char message[256] = {};
+	sprintf_s(message, sizeof(message), "It can't be read, check the editor where you're editing the file, there might be a problem with it. Attempt[%i]", attempts);
+	GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Warning, nullptr, filename, message);
+
+	return false;
+}
+
+/// <summary>
+/// Hash bytes (FNV-1a 64)
+/// </summary>
+/// <param name="data">Data</param>
+/// <param name="size">Data size</param>
+/// <param name="hash">Previous hash, for hashing several buffers</param>
+/// <returns>Hash</returns>
+inline unsigned long long HashBytes(const void* data, size_t size, unsigned long long hash = 14695981039346656037ULL)
+{
+	auto bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+/// <summary>
+/// Hash token stream of preprocessed shader
+/// Whitespaces and #line directives is skipped, so only real code changes the hash
+/// </summary>
+/// <param name="text">Preprocessed text</param>
+/// <param name="size">Text size</param>
+/// <returns>Hash</returns>
+inline unsigned long long HashShaderTokens(const char* text, size_t size)
+{
+	auto isWordChar = [](char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.'; };
+	auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v'; };
+
+	unsigned long long hash = HashBytes(nullptr, 0);
+	bool isLineStart = true;
+	char previous = 0;
+	bool hasSpace = false;
+
+	size_t i = 0;
+	while (i < size && text[i])
+	{
+		char c = text[i];
+		if (isSpace(c))
+		{
+			if (c == '\n')
+				isLineStart = true;
+			hasSpace = true;
+			i++;
+			continue;
+		}
+
+		// Skip #line directives, they are changed when lines is added in comments
+		if (isLineStart && c == '#')
+		{
+			size_t j = i + 1;
+			while (j < size && (text[j] == ' ' || text[j] == '\t'))
+				j++;
+			if (j + 4 <= size && !strncmp(text + j, "line", 4))
+			{
+				while (i < size && text[i] && text[i] != '\n')
+					i++;
+				continue;
+			}
+		}
+		isLineStart = false;
+
+		// Whitespace is matter between two words ("a b" != "ab") and between two punctuators ("- -" != "--", "> >" != ">>"),
+		// between word and punctuator it is only formatting ("a + b" == "a+b")
+		bool isWordSeparator = isWordChar(previous) && isWordChar(c);
+		bool isPunctuatorSeparator = previous && !isWordChar(previous) && !isWordChar(c);
+		if (hasSpace && (isWordSeparator || isPunctuatorSeparator))
+		{
+			char separator = ' ';
+			hash = HashBytes(&separator, 1, hash);
+		}
+		hasSpace = false;
+
+		// String literals is hashed as is
+		if (c == '"')
+		{
+			size_t j = i + 1;
+			while (j < size && text[j] && text[j] != '"' && text[j] != '\n')
+				j += (text[j] == '\\' && j + 1 < size) ? 2 : 1;
+			j = j < size ? j + 1 : size;
+			hash = HashBytes(text + i, j - i, hash);
+			previous = '"';
+			i = j;
+			continue;
+		}
+
+		hash = HashBytes(&c, 1, hash);
+		previous = c;
+		i++;
+	}
+
+	return hash;
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+/// <param name="hlslPath">Path to root .hlsl file</param>
+inline ShaderIncludeHandler::ShaderIncludeHandler(const char* hlslPath)
+{
+	std::string path = hlslPath ? hlslPath : "";
+	auto slash = path.find_last_of("/\\");
+	mRootDirectory = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+inline ShaderIncludeHandler::~ShaderIncludeHandler()
+{
+	mBuffers.clear();
+}
+
+/// <summary>
+/// Open included file
+/// </summary>
+inline HRESULT STDMETHODCALLTYPE ShaderIncludeHandler::Open(D3D_INCLUDE_TYPE includeType, LPCSTR fileName, LPCVOID parentData, LPCVOID* data, UINT* bytes)
+{
+	// Relative to file which is include it
+	std::string directory = mRootDirectory;
+	auto parent = mDirectories.find(parentData);
+	if (parent != mDirectories.end())
+		directory = parent->second;
+
+	std::string path = fileName;
+	bool isAbsolute = (path.size() > 1 && path[1] == ':') || (!path.empty() && (path[0] == '/' || path[0] == '\\'));
+	if (!isAbsolute)
+		path = directory + path;
+
+	// Time before reading, if file is changed while reading - it will be compiled again
+	unsigned long long time = 0;
+	if (!GetFileWriteTime(path.c_str(), time))
+	{
+		// Missing header is watched too, bundle is compiled again when it is created
+		mDependencies[path] = 0;
+		return E_FAIL;
+	}
+
+	// Same header is read once for all compiles
+	auto buffer = GetShaderIncludeCache().Load(path.c_str(), time);
+	if (!buffer)
+		return E_FAIL;
+	mBuffers.push_back(buffer);
+
+	auto slash = path.find_last_of("/\\");
+	mDirectories[buffer->data()] = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+	mDependencies[path] = time;
+
+	*data = buffer->data();
+	*bytes = (UINT)buffer->size();
+	return S_OK;
+}
+
+/// <summary>
+/// Close included file
+/// </summary>
+inline HRESULT STDMETHODCALLTYPE ShaderIncludeHandler::Close(LPCVOID data)
+{
+	for (size_t i = 0; i < mBuffers.size(); i++)
+	{
+		if (mBuffers[i]->data() == data)
+		{
+			mBuffers.erase(mBuffers.begin() + i);
+			break;
+		}
+	}
+
+	// Same cached file can be opened twice (without include guard)
+	auto isOpened = std::any_of(mBuffers.begin(), mBuffers.end(), [&](const ShaderIncludeCache::Buffer& buffer) { return buffer->data() == data; });
+	if (!isOpened)
+		mDirectories.erase(data);
+
+	return S_OK;
+}
+
+inline ShaderIncludeCache::ShaderIncludeCache()
+{
+	mStatistics = {};
+}
+
+/// <summary>
+/// Get file, read it only when it is not cached or changed
+/// </summary>
+/// <param name="path">Path to file</param>
+/// <param name="writeTime">Write time of file, taken before call</param>
+/// <returns>Shared buffer, nullptr if file can't be read</returns>
+inline ShaderIncludeCache::Buffer ShaderIncludeCache::Load(const char* path, unsigned long long writeTime)
+{
+	auto key = NormalizeShaderPath(path);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto entry = mEntries.find(key);
+		if (entry != mEntries.end() && entry->second.writeTime == writeTime)
+		{
+			mStatistics.hits++;
+			mStatistics.bytesSaved += entry->second.buffer->size();
+			return entry->second.buffer;
+		}
+	}
+
+	// Read without lock, other compiles is not waiting for it
+	auto buffer = std::make_shared<std::vector<unsigned char>>();
+	if (!ReadFile(path, *buffer))
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mStatistics.misses++;
+	mStatistics.bytesRead += buffer->size();
+
+	auto& entry = mEntries[key];
+	if (entry.buffer)
+		mStatistics.cachedBytes -= entry.buffer->size();
+	entry.writeTime = writeTime;
+	entry.buffer = buffer;
+	mStatistics.cachedBytes += buffer->size();
+
+	return buffer;
+}
+
+/// <summary>
+/// Forget file, compiles which is using it keep their buffer
+/// </summary>
+/// <param name="path">Path to file</param>
+inline void ShaderIncludeCache::Invalidate(const char* path)
+{
+	auto key = NormalizeShaderPath(path);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto entry = mEntries.find(key);
+	if (entry == mEntries.end())
+		return;
+
+	mStatistics.cachedBytes -= entry->second.buffer->size();
+	mEntries.erase(entry);
+}
+
+/// <summary>
+/// Forget all files
+/// </summary>
+inline void ShaderIncludeCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mEntries.clear();
+	mStatistics.cachedBytes = 0;
+}
+
+/// <summary>
+/// Hits, misses and saved bytes
+/// </summary>
+/// <returns>Statistics</returns>
+inline ShaderIncludeCacheStatistics ShaderIncludeCache::GetStatistics()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto statistics = mStatistics;
+	statistics.fileCount = mEntries.size();
+	return statistics;
+}
+
+/// <summary>
+/// Process-wide include cache
+/// </summary>
+/// <returns>Include cache</returns>
+inline ShaderIncludeCache& GetShaderIncludeCache()
+{
+	static ShaderIncludeCache cache;
+	return cache;
+}
+
+/// <summary>
+/// Get included files
+/// </summary>
+/// <returns>Included files and last time when they are changed</returns>
+inline std::map<std::string, unsigned long long>& ShaderIncludeHandler::GetDependencies()
+{
+	return mDependencies;
+}
+
+/// <summary>
+/// Preprocess shader source (first, cheap stage of compilation)
+/// </summary>
+/// <param name="info">Shader information</param>
+/// <param name="source">Shader source</param>
+/// <param name="preprocessed">out preprocessed shader</param>
+/// <param name="errorMessage">out error message, can be nullptr</param>
+/// <returns>true if preprocessed otherwise false</returns>
+inline bool PreprocessShader(const ShaderInformation& info, const std::vector<unsigned char>& source, PreprocessedShader& preprocessed, std::string* errorMessage = nullptr)
+{
+	ShaderTraceScope trace("Preprocess", info.localName);
+	ShaderIncludeHandler includeHandler(info.hlslPath);
+
+	ID3DBlob* text = nullptr;
+	ID3DBlob* error = nullptr;
+	auto hr = D3DPreprocess(source.data(), source.size(), info.hlslPath, nullptr, &includeHandler, &text, &error);
+	if (FAILED(hr))
+	{
+		if (error)
+		{
+			GetShaderDiagnostics().ReportCompilerOutput(info.localName, (const char*)error->GetBufferPointer());
+			if (errorMessage)
+				*errorMessage = (const char*)error->GetBufferPointer();
+			error->Release();
+			error = nullptr;
+		}
+
+		// Included files which is read before error
+		preprocessed.dependencies = includeHandler.GetDependencies();
+		return false;
+	}
+
+	if (error)
+		error->Release();
+
+	auto data = (const char*)text->GetBufferPointer();
+	auto size = text->GetBufferSize();
+	while (size && data[size - 1] == 0)
+		size--;
+
+	preprocessed.text.assign(data, size);
+	preprocessed.tokenHash = HashShaderTokens(preprocessed.text.data(), preprocessed.text.size());
+	preprocessed.dependencies = includeHandler.GetDependencies();
+	text->Release();
+
+	return true;
+}
+
+/// <summary>
+/// Get compile key for preprocessed shader
+/// Key is depends from token stream, entry point, shader version and compile flags
+/// </summary>
+/// <param name="info">Shader information</param>
+/// <param name="tokenHash">Hash of preprocessed token stream</param>
+/// <param name="flags">Compile flags</param>
+/// <returns>Compile key</returns>
+inline unsigned long long GetShaderCompileKey(const ShaderInformation& info, unsigned long long tokenHash, unsigned int flags = HOT_RELOADABLE_SHADERS_COMPILE_FLAGS)
+{
+	auto key = HashBytes(&tokenHash, sizeof(tokenHash));
+	key = HashBytes(info.entryPoint, strlen(info.entryPoint) + 1, key);
+	auto profile = GetShaderProfile(info);
+	key = HashBytes(profile, strlen(profile) + 1, key);
+	key = HashBytes(&flags, sizeof(flags), key);
+	return key;
+}
+
+/// <summary>
+/// Compile preprocessed shader to bytecode (second, expensive stage of compilation)
+/// *Note* Same path is used by runtime and by offline builds (ShaderBuilder)
+/// </summary>
+/// <param name="info">Shader information</param>
+/// <param name="preprocessed">Preprocessed shader</param>
+/// <param name="cache">Persisted cache, can be nullptr</param>
+/// <param name="bytecode">out bytecode</param>
+/// <param name="isFromCache">out true if bytecode is loaded from cache, can be nullptr</param>
+/// <param name="errorMessage">out error message, can be nullptr</param>
+/// <param name="flags">Compile flags</param>
+/// <returns>true if compiled otherwise false</returns>
+inline bool CompileShaderBytecode(const ShaderInformation& info, const PreprocessedShader& preprocessed, ShaderCache* cache, std::vector<unsigned char>& bytecode,
+	bool* isFromCache = nullptr, std::string* errorMessage = nullptr, unsigned int flags = HOT_RELOADABLE_SHADERS_COMPILE_FLAGS)
+{
+	if (isFromCache)
+		*isFromCache = false;
+
+	// Try take it from cache
+	unsigned long long key = 0;
+	if (cache && cache->IsEnabled())
+	{
+		ShaderTraceScope trace("CacheLoad", info.localName);
+
+		key = GetShaderCompileKey(info, preprocessed.tokenHash, flags);
+		if (cache->Load(key, bytecode))
+		{
+			if (isFromCache)
+				*isFromCache = true;
+			return true;
+		}
+	}
+
+	// Compile shader
+	ShaderTraceScope trace("Compile", info.localName);
+	ID3DBlob* shader = nullptr;
+	ID3DBlob* error = nullptr;
+	// Includes is already resolved by preprocess stage
+	auto hr = D3DCompile(preprocessed.text.data(), preprocessed.text.size(), info.hlslPath, nullptr, nullptr, info.entryPoint, GetShaderProfile(info), flags, 0, &shader, &error);
+	if (FAILED(hr))
+	{
+		if (error)
+		{
+			GetShaderDiagnostics().ReportCompilerOutput(info.localName, (const char*)error->GetBufferPointer());
+			if (errorMessage)
+				*errorMessage = (const char*)error->GetBufferPointer();
+			error->Release();
+			error = nullptr;
+		}
+		return false;
+	}
+
+	// Warnings
+	if (error)
+	{
+		GetShaderDiagnostics().ReportCompilerOutput(info.localName, (const char*)error->GetBufferPointer());
+		error->Release();
+	}
+
+	auto data = (const unsigned char*)shader->GetBufferPointer();
+	bytecode.assign(data, data + shader->GetBufferSize());
+	shader->Release();
+
+	// Save in cache
+	if (cache && cache->IsEnabled())
+	{
+		cache->Store(key, bytecode.data(), bytecode.size());
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Compile file
+/// </summary>
+/// <param name="filePath">.hlsl path</param>
+/// <param name="info">Shader information</param>
+/// <returns>bool is compiled otherwise false</returns>
+inline bool HotReloadableShaders::CompileFile(ShaderInformation& info)
+{
+	std::vector<unsigned char> fileBuffer;
+
+	bool isDone = false;
+	{
+		ShaderTraceScope trace("Read", info.localName);
+		isDone = ReadFile(info.hlslPath, fileBuffer);
+	}
+	if (!isDone)
+		return false;
+
+	// Preprocess, it is cheap
+	PreprocessedShader preprocessed = {};
+	isDone = PreprocessShader(info, fileBuffer, preprocessed);
+	if (!isDone)
+	{
+		// Error can be in included file, it is not preprocessed again until something is changed
+		UpdateFailedDependencies(info, preprocessed.dependencies);
+		return false;
+	}
+
+	// Only comments, whitespaces or dead code is changed
+	if (!IsPreprocessedShaderChanged(info, preprocessed))
+	{
+		GetBundleDependencies(info.localName) = preprocessed.dependencies;
+		return true;
+	}
+
+	// Compile shader (or take it from cache)
+	// In iteration mode without optimization, optimized tier is compiled later
+	auto tier = bIsIterationMode ? ShaderCompileTier::Iteration : ShaderCompileTier::Optimized;
+	auto flags = bIsIterationMode ? HOT_RELOADABLE_SHADERS_ITERATION_COMPILE_FLAGS : HOT_RELOADABLE_SHADERS_COMPILE_FLAGS;
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<unsigned char> bytecode;
+	isDone = CompileShaderBytecode(info, preprocessed, &mShaderCache, bytecode, nullptr, nullptr, flags);
+	if (!isDone)
+	{
+		// Watch included files anyway, error can be in them
+		GetBundleDependencies(info.localName) = preprocessed.dependencies;
+		return false;
+	}
+
+	auto milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Create compiled shaders
+	auto isCreated = CreateShader(info, bytecode.data(), bytecode.size(), tier);
+	if (!isCreated)
+		return false;
+
+	ApplyCompiledShader(info, preprocessed, bytecode, tier, milliseconds);
+
+	// Release buffers
+	fileBuffer.clear();
+
+	return true;
+}
+
+/// <summary>
+/// Remember compiled source of created shader, write .cso
+/// </summary>
+/// <param name="info">Shader information</param>
+/// <param name="preprocessed">Compiled source, it is moved for iteration tier</param>
+/// <param name="bytecode">Compiled bytecode</param>
+/// <param name="tier">Compile tier of bytecode</param>
+/// <param name="milliseconds">Compile time</param>
+inline void HotReloadableShaders::ApplyCompiledShader(ShaderInformation& info, PreprocessedShader& preprocessed, const std::vector<unsigned char>& bytecode, ShaderCompileTier tier, double milliseconds)
+{
+	// Remember what is compiled
+	auto& state = GetBundleState(info.localName);
+	GetBundleTokenHash(info.localName) = preprocessed.tokenHash;
+	GetBundleDependencies(info.localName) = preprocessed.dependencies;
+
+	if (tier == ShaderCompileTier::Iteration)
+	{
+		state.timings.iterationMilliseconds = milliseconds;
+		state.iterationSource = std::make_shared<PreprocessedShader>(std::move(preprocessed));
+		state.lastChangeTime = std::chrono::steady_clock::now();
+
+		char message[128] = {};
+		sprintf_s(message, sizeof(message), "Iteration tier is swapped in: %.2f ms", milliseconds);
+		GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Info, info.localName, info.hlslPath, message);
+		return;
+	}
+
+	state.timings.optimizedMilliseconds = milliseconds;
+	state.iterationSource.reset();
+
+	// Generate .cso from compiled shaders
+	if (info.bSaveToCSO)
+	{
+		GenerateCSO(info, (void*)bytecode.data(), (int)bytecode.size());
+	}
+}
+
+/// <summary>
+/// Set compile workers
+/// </summary>
+/// <param name="maxConcurrency">Max count of compiles at once, 0 - all hardware threads</param>
+/// <param name="priority">OS priority of workers (THREAD_PRIORITY_*)</param>
+/// <param name="affinityMask">CPUs of workers, 0 - all CPUs of process</param>
+inline void HotReloadableShaders::SetCompileWorkers(unsigned int maxConcurrency, int priority, unsigned long long affinityMask)
+{
+	mWorkerConcurrency = maxConcurrency;
+	mWorkerPriority = priority;
+	mWorkerAffinityMask = affinityMask;
+
+	if (mBatchScheduler)
+		ConfigureCompileScheduler(*mBatchScheduler);
+	if (mBackgroundScheduler)
+		ConfigureCompileScheduler(*mBackgroundScheduler);
+}
+
+/// <summary>
+/// Report time of frame, compiles is throttled when frame is over budget
+/// </summary>
+/// <param name="frameMilliseconds">Time of last frame</param>
+/// <param name="budgetMilliseconds">Target time of frame</param>
+inline void HotReloadableShaders::ReportFrameTime(double frameMilliseconds, double budgetMilliseconds)
+{
+	auto maxThrottle = std::max(std::thread::hardware_concurrency(), 1u);
+	auto throttle = mWorkerThrottle;
+
+	// Back off fast, recover slow
+	if (frameMilliseconds > budgetMilliseconds)
+		throttle = std::max(throttle / 2, 1u);
+	else if (frameMilliseconds < budgetMilliseconds * 0.8 && throttle < maxThrottle)
+		throttle++;
+
+	if (throttle == mWorkerThrottle)
+		return;
+
+	mWorkerThrottle = throttle;
+	if (mBatchScheduler)
+		mBatchScheduler->SetThrottle(throttle);
+	if (mBackgroundScheduler)
+		mBackgroundScheduler->SetThrottle(throttle);
+}
+
+/// <summary>
+/// Queue depth and utilization of background compile workers
+/// </summary>
+/// <returns>Statistics of all workers, utilization is counted since previous call</returns>
+inline ShaderSchedulerStatistics HotReloadableShaders::GetCompileStatistics()
+{
+	ShaderSchedulerStatistics total = {};
+	double busyThreads = 0.0;
+	for (auto scheduler : { mBatchScheduler.get(), mBackgroundScheduler.get() })
+	{
+		if (!scheduler)
+			continue;
+
+		auto statistics = scheduler->GetStatistics();
+		total.threadCount += statistics.threadCount;
+		total.concurrency += statistics.concurrency;
+		total.queueDepth += statistics.queueDepth;
+		total.activeJobs += statistics.activeJobs;
+		total.completedJobs += statistics.completedJobs;
+		busyThreads += statistics.utilization * statistics.threadCount;
+	}
+
+	total.utilization = total.threadCount ? busyThreads / total.threadCount : 0.0;
+	return total;
+}
+
+/// <summary>
+/// Create scheduler of compile workers with current settings
+/// </summary>
+/// <param name="threadCount">Count of threads, 0 - all hardware threads</param>
+/// <returns>New scheduler</returns>
+inline ShaderJobScheduler* HotReloadableShaders::CreateCompileScheduler(unsigned int threadCount)
+{
+	auto scheduler = new ShaderJobScheduler(threadCount);
+	ConfigureCompileScheduler(*scheduler);
+	return scheduler;
+}
+
+/// <summary>
+/// Apply settings of compile workers
+/// </summary>
+/// <param name="scheduler">Scheduler</param>
+inline void HotReloadableShaders::ConfigureCompileScheduler(ShaderJobScheduler& scheduler)
+{
+	scheduler.SetMaxConcurrency(mWorkerConcurrency);
+	scheduler.SetThrottle(mWorkerThrottle);
+	scheduler.SetThreadPriority(mWorkerPriority);
+	scheduler.SetAffinityMask(mWorkerAffinityMask);
+}
+
+/// <summary>
+/// Compile change set in parallel
+/// Read, preprocess and compile is done on worker threads, shaders is created when change set is published
+/// </summary>
+/// <param name="changeSet">Changed bundles and write times of their files</param>
+/// <param name="isTransactional">Publish all bundles or nothing</param>
+inline void HotReloadableShaders::StartShaderBatch(const std::vector<std::pair<ShaderInformation*, unsigned long long>>& changeSet, bool isTransactional)
+{
+	auto batch = std::make_shared<ShaderBatch>();
+	batch->isTransactional = isTransactional;
+	batch->isWarmUp = false;
+	batch->compiles.resize(changeSet.size());
+	batch->remaining = (unsigned int)changeSet.size();
+
+	for (size_t i = 0; i < changeSet.size(); i++)
+	{
+		auto& compile = batch->compiles[i];
+		compile.info = *changeSet[i].first;
+		compile.writeTime = changeSet[i].second;
+		compile.previousHash = GetBundleTokenHash(compile.info.localName);
+		compile.tier = bIsIterationMode ? ShaderCompileTier::Iteration : ShaderCompileTier::Optimized;
+		compile.flags = bIsIterationMode ? HOT_RELOADABLE_SHADERS_ITERATION_COMPILE_FLAGS : HOT_RELOADABLE_SHADERS_COMPILE_FLAGS;
+		mBundles.flags[FindBundle(compile.info.localName)] |= BundleInFlight;
+	}
+
+	if (!mBatchScheduler)
+		mBatchScheduler.reset(CreateCompileScheduler(0));
+
+	for (size_t i = 0; i < batch->compiles.size(); i++)
+	{
+		mBatchScheduler->Submit([this, batch, i]() {
+			auto& compile = batch->compiles[i];
+			ShaderTraceScope trace("BatchCompile", compile.info.localName);
+
+			std::vector<unsigned char> fileBuffer;
+			compile.isSucceeded = ReadFile(compile.info.hlslPath, fileBuffer) && PreprocessShader(compile.info, fileBuffer, compile.preprocessed);
+			compile.isChanged = compile.isSucceeded && compile.preprocessed.tokenHash != compile.previousHash;
+
+			if (compile.isChanged)
+			{
+				auto start = std::chrono::steady_clock::now();
+				compile.isSucceeded = CompileShaderBytecode(compile.info, compile.preprocessed, &mShaderCache, compile.bytecode, nullptr, nullptr, compile.flags);
+				compile.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(batch->mutex);
+				batch->remaining--;
+			}
+			batch->finished.notify_all();
+		});
+	}
+
+	mPendingBatch = batch;
+}
+
+/// <summary>
+/// Publish all bundles of compiled change set
+/// If any bundle is failed (compile or shader creation), nothing is published and last good set is kept,
+/// succeeded bundles wait for next change set
+/// </summary>
+inline void HotReloadableShaders::CommitShaderBatch()
+{
+	auto batch = std::move(mPendingBatch);
+	ShaderTraceScope trace("BatchCommit");
+
+	unsigned int failedCount = 0;
+	for (auto& compile : batch->compiles)
+		failedCount += compile.isSucceeded ? 0 : 1;
+
+	// Create all shaders first, old shaders is still used
+	std::vector<std::vector<IUnknown*>> objects(batch->compiles.size());
+	for (size_t i = 0; i < batch->compiles.size(); i++)
+	{
+		if (batch->isTransactional && failedCount)
+			break;
+
+		auto& compile = batch->compiles[i];
+		if (compile.isSucceeded && compile.isChanged && !CreateShaderObjects(compile.info, compile.bytecode.data(), compile.bytecode.size(), objects[i]))
+		{
+			compile.isSucceeded = false;
+			failedCount++;
+		}
+	}
+
+	// Change set is published only if all bundles is succeeded
+	bool isRejected = batch->isTransactional && failedCount;
+
+	for (size_t i = 0; i < batch->compiles.size(); i++)
+	{
+		auto& compile = batch->compiles[i];
+		auto info = GetShaderInformationByLocalName(compile.info.localName);
+		auto& state = GetBundleState(compile.info.localName);
+		mBundles.flags[FindBundle(compile.info.localName)] &= ~BundleInFlight;
+
+		// Watch included files anyway, error can be in them
+		GetBundleWriteTime(compile.info.localName) = compile.writeTime;
+		if (compile.isSucceeded)
+			GetBundleDependencies(compile.info.localName) = compile.preprocessed.dependencies;
+		else
+			UpdateFailedDependencies(compile.info, compile.preprocessed.dependencies);
+		if (info)
+			WatchBundleDirectories(*info);
+
+		if (isRejected)
+		{
+			for (auto shader : objects[i])
+			{
+				if (shader)
+					shader->Release();
+			}
+			state.isBatchPending = compile.isSucceeded && compile.isChanged;
+			continue;
+		}
+
+		state.isBatchPending = false;
+		if (batch->isWarmUp && state.isWarmUpPending)
+		{
+			state.isWarmUpPending = false;
+			CountTagReadiness(FindBundle(compile.info.localName), 0, 0, -1);
+			mWarmUpProgress.finished++;
+			mWarmUpProgress.failed += compile.isSucceeded ? 0 : 1;
+		}
+
+		if (!compile.isSucceeded || !compile.isChanged || !info)
+			continue;
+
+		PublishShaderObjects(*info, objects[i], compile.bytecode.data(), compile.bytecode.size(), compile.tier);
+		ApplyCompiledShader(*info, compile.preprocessed, compile.bytecode, compile.tier, compile.milliseconds);
+	}
+
+	// Errors of bundles is already reported by compiler
+	if (!batch->isTransactional)
+		return;
+
+	char message[256] = {};
+	if (failedCount)
+		sprintf_s(message, sizeof(message), "Change set is not published: %u of %zu bundles is failed, last good shaders is kept", failedCount, batch->compiles.size());
+	else
+		sprintf_s(message, sizeof(message), "Change set of %zu bundles is published", batch->compiles.size());
+
+	GetShaderDiagnostics().Report(failedCount ? ShaderDiagnosticSeverity::Error : ShaderDiagnosticSeverity::Info, nullptr, nullptr, message);
+}
+
+/// <summary>
+/// File has same content as when archive is built
+/// Size and write time is taken without opening file, content is read and hashed only when size is same and write time is other
+/// (fresh checkout, copy to other machine). Result is kept until watcher reports change of file
+/// </summary>
+/// <param name="path">Path to file</param>
+/// <param name="file">File of archive entry</param>
+/// <returns></returns>
+inline bool HotReloadableShaders::IsSameArchiveFile(const std::string& path, const ShaderArchiveFile& file)
+{
+	auto found = mArchiveFiles.find(NormalizeShaderPath(path.c_str()));
+	if (found == mArchiveFiles.end())
+	{
+		ArchiveFileState state = {};
+		state.isExist = GetFileSizeAndWriteTime(path.c_str(), state.size, state.writeTime);
+		found = mArchiveFiles.emplace(NormalizeShaderPath(path.c_str()), state).first;
+	}
+
+	auto& state = found->second;
+	if (!state.isExist || state.size != file.size)
+		return false;
+	if (state.writeTime == file.writeTime)
+		return true;
+
+	if (!state.isHashed)
+	{
+		std::vector<unsigned char> content;
+		state.isHashed = true;
+		state.contentHash = ReadFile(path.c_str(), content) ? HashBytes(content.data(), content.size()) : 0;
+	}
+	return state.contentHash == file.contentHash;
+}
+
+/// <summary>
+/// Create shader from packed archive
+/// Entry is valid only when content of source and included files is same as when archive was built
+/// (checkout directory can differ), otherwise watcher compiles it again and hot reloaded shader is used.
+/// Files of created bundle is not checked by Start() until watcher reports change of them
+/// </summary>
+/// <param name="info">Shader information</param>
+/// <returns>true if shader is created from archive</returns>
+inline bool HotReloadableShaders::LoadFromArchive(ShaderInformation& info)
+{
+	if (!mShaderArchive.IsOpen())
+		return false;
+
+	ShaderTraceScope trace("ArchiveLoad", info.localName);
+
+	auto entry = mShaderArchive.Find(info.localName);
+	if (!entry || entry->shaderType != (unsigned int)info.localShaderType)
+		return false;
+
+	// Entry point, shader version or compile flags is changed
+	if (GetShaderCompileKey(info, entry->tokenHash) != entry->compileKey)
+		return false;
+
+	if (!IsSameArchiveFile(info.hlslPath, entry->source))
+		return false;
+
+	std::string sourcePath = info.hlslPath;
+	auto slash = sourcePath.find_last_of("/\\");
+	auto sourceDirectory = slash == std::string::npos ? std::string() : sourcePath.substr(0, slash + 1);
+
+	std::vector<std::string> dependencyPaths;
+	auto dependencies = mShaderArchive.GetDependencies(entry);
+	for (unsigned int i = 0; dependencies && i < entry->dependencyCount; i++)
+	{
+		auto dependencyPath = mShaderArchive.GetString(dependencies[i].pathOffset);
+		if (!dependencyPath)
+			return false;
+
+		std::string path = dependencies[i].flags & ShaderArchiveDependencyRelative ? sourceDirectory + dependencyPath : dependencyPath;
+		if (!IsSameArchiveFile(path, dependencies[i].file))
+			return false;
+		dependencyPaths.push_back(path);
+	}
+
+	std::vector<unsigned char> buffer;
+	auto bytecode = mShaderArchive.GetBytecode(entry, buffer);
+	if (!bytecode)
+		return false;
+
+	if (!CreateShader(info, bytecode, entry->bytecodeSize))
+		return false;
+
+	// Times is unknown, bundle is compiled from files when watcher reports change of any of them
+	auto index = FindBundle(info.localName);
+	mBundles.tokenHashes[index] = entry->tokenHash;
+	mBundles.dependencies[index].clear();
+	for (auto& path : dependencyPaths)
+		mBundles.dependencies[index][path] = 0;
+	mBundles.flags[index] |= BundleFromArchive;
+
+	GetBundleWriteTime(info.localName) = 0;
+	return true;
+}
+
+/// <summary>
+/// Swap in optimized shaders and start optimized compilation of quiet files
+/// </summary>
+inline void HotReloadableShaders::UpdateCompileTiers()
+{
+	// Swap in optimized shaders
+	std::vector<OptimizedTierResult> results;
+	{
+		std::lock_guard<std::mutex> lock(mOptimizedResultsMutex);
+		results.swap(mOptimizedResults);
+	}
+
+	for (auto& result : results)
+	{
+		auto& state = GetBundleState(result.localName);
+		state.isOptimizing = false;
+
+		// File is changed again while compiling
+		if (!result.isSucceeded || state.tier != ShaderCompileTier::Iteration || GetBundleTokenHash(result.localName) != result.tokenHash)
+			continue;
+
+		auto info = GetShaderInformationByLocalName(result.localName);
+		if (!info || !CreateShader(*info, result.bytecode.data(), result.bytecode.size()))
+			continue;
+
+		state.timings.optimizedMilliseconds = result.milliseconds;
+		state.iterationSource.reset();
+
+		char message[256] = {};
+		sprintf_s(message, sizeof(message), "Optimized tier is swapped in: iteration %.2f ms, optimized %.2f ms",
+			state.timings.iterationMilliseconds, state.timings.optimizedMilliseconds);
+		GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Info, info->localName, info->hlslPath, message);
+
+		if (info->bSaveToCSO)
+		{
+			GenerateCSO(*info, result.bytecode.data(), (int)result.bytecode.size());
+		}
+	}
+
+	// Start optimized compilation of quiet files
+	ShaderTraceScope trace("Debounce");
+	auto now = std::chrono::steady_clock::now();
+	for (auto& info : mBundles.informations)
+	{
+		auto& state = GetBundleState(info.localName);
+		if (state.tier != ShaderCompileTier::Iteration || state.isOptimizing || !state.iterationSource)
+			continue;
+
+		if (now - state.lastChangeTime < std::chrono::milliseconds(mOptimizeDelay))
+			continue;
+
+		if (!mBackgroundScheduler)
+			mBackgroundScheduler.reset(CreateCompileScheduler(1));
+
+		state.isOptimizing = true;
+		auto source = state.iterationSource;
+		ShaderInformation information = info;
+		mBackgroundScheduler->Submit([this, information, source]() {
+			ShaderTraceScope trace("OptimizedCompile", information.localName);
+			OptimizedTierResult result = {};
+			result.localName = information.localName;
+			result.tokenHash = source->tokenHash;
+
+			auto start = std::chrono::steady_clock::now();
+			result.isSucceeded = CompileShaderBytecode(information, *source, &mShaderCache, result.bytecode);
+			result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			std::lock_guard<std::mutex> lock(mOptimizedResultsMutex);
+			mOptimizedResults.push_back(std::move(result));
+		});
+	}
+}
+
+/// <summary>
+/// Flag bundle which file is vanished or back
+/// Editors which delete and create file (or rename temp file) make it missing for a moment,
+/// so warning is reported only when it is missing longer
+/// </summary>
+/// <param name="index">Index of bundle</param>
+/// <param name="isMissing">Is file found</param>
+/// <returns>true if file is back</returns>
+inline bool HotReloadableShaders::UpdateMissingBundle(unsigned int index, bool isMissing)
+{
+	// Found file of not missing bundle is usual case of scan, cold state is not touched
+	auto& flags = mBundles.flags[index];
+	if (!isMissing && !(flags & BundleMissing))
+		return false;
+
+	auto& info = mBundles.informations[index];
+	auto& state = mBundles.states[index];
+	auto now = std::chrono::steady_clock::now();
+
+	if (isMissing)
+	{
+		if (!(flags & BundleMissing))
+		{
+			flags |= BundleMissing;
+			state.isMissingReported = false;
+			state.missingTime = now;
+		}
+
+		if (!state.isMissingReported && now - state.missingTime >= std::chrono::milliseconds(1000))
+		{
+			state.isMissingReported = true;
+			GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Warning, info.localName, info.hlslPath,
+				"File is missing, last shader is used until file is back");
+		}
+		return false;
+	}
+
+	if (state.isMissingReported)
+		GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Info, info.localName, info.hlslPath, "File is back, it is compiled again");
+
+	flags &= ~BundleMissing;
+	state.isMissingReported = false;
+	return true;
+}
+
+/// <summary>
+/// Remember dependencies of failed compile
+/// Preprocess stops at first error, so old dependencies is kept with their current times
+/// </summary>
+/// <param name="info">Shader information</param>
+/// <param name="dependencies">Included files which is read by failed compile</param>
+inline void HotReloadableShaders::UpdateFailedDependencies(ShaderInformation& info, const std::map<std::string, unsigned long long>& dependencies)
+{
+	auto& bundleDependencies = GetBundleDependencies(info.localName);
+	for (auto& dependency : bundleDependencies)
+	{
+		unsigned long long time = 0;
+		GetWatchedFileWriteTime(dependency.first.c_str(), time);
+		dependency.second = time;
+	}
+
+	for (auto& dependency : dependencies)
+		bundleDependencies[dependency.first] = dependency.second;
+}
+
+/// <summary>
+/// Watch directories of bundle file and included files
+/// </summary>
+/// <param name="info">Shader information</param>
+inline void HotReloadableShaders::WatchBundleDirectories(ShaderInformation& info)
+{
+	auto index = FindBundle(info.localName);
+	auto& dependencies = mBundles.dependencies[index];
+
+	// Paths is normalized once per compile, not by every scan
+	auto& watchedPaths = mBundles.watchedPaths[index];
+	watchedPaths.clear();
+	watchedPaths.push_back(NormalizeShaderPath(info.hlslPath));
+	for (auto& dependency : dependencies)
+		watchedPaths.push_back(NormalizeShaderPath(dependency.first.c_str()));
+
+	if (bIsPollingMode)
+	{
+		mPollingWatcher.WatchFile(info.hlslPath);
+		for (auto& dependency : dependencies)
+			mPollingWatcher.WatchFile(dependency.first.c_str());
+		return;
+	}
+
+	mDirectoryWatcher.WatchFileDirectory(info.hlslPath);
+	for (auto& dependency : dependencies)
+		mDirectoryWatcher.WatchFileDirectory(dependency.first.c_str());
+}
+
+/// <summary>
+/// Write time of watched file
+/// In polling mode it is taken from last listing, file system is touched only until directory is listed first time
+/// </summary>
+/// <param name="path">Path to file</param>
+/// <param name="time">out write time</param>
+/// <returns>false if file is not exist</returns>
+inline bool HotReloadableShaders::GetWatchedFileWriteTime(const char* path, unsigned long long& time)
+{
+	bool isExist = false;
+	if (bIsPollingMode && mPollingWatcher.GetWriteTime(path, time, isExist))
+		return isExist;
+
+	return GetFileWriteTime(path, time);
+}
+
+/// <summary>
+/// Index of bundle in registry
+/// </summary>
+/// <param name="localName">local name of shader information, can be temporary string</param>
+/// <returns>InvalidBundleIndex if bundle is not added</returns>
+inline unsigned int HotReloadableShaders::FindBundle(const char* localName)
+{
+	if (!localName)
+		return InvalidBundleIndex;
+
+	auto found = mBundles.indices.find(localName);
+	return found != mBundles.indices.end() ? found->second : InvalidBundleIndex;
+}
+
+/// <summary>
+/// Has bundle tag
+/// </summary>
+/// <param name="index">Index of bundle</param>
+/// <param name="tag">Tag, nullptr - any bundle</param>
+/// <returns></returns>
+inline bool HotReloadableShaders::HasBundleTag(unsigned int index, const char* tag)
+{
+	if (!tag)
+		return true;
+
+	auto& tags = mBundles.states[index].tags;
+	return std::any_of(tags.begin(), tags.end(), [tag](const char* bundleTag) { return !strcmp(bundleTag, tag); });
+}
+
+/// <summary>
+/// State of added bundle
+/// </summary>
+/// <param name="localName">local name of added shader information</param>
+/// <returns></returns>
+inline HotReloadableShaders::ShaderBundleState& HotReloadableShaders::GetBundleState(const char* localName)
+{
+	return mBundles.states[FindBundle(localName)];
+}
+
+/// <summary>
+/// Write time of .hlsl when added bundle is compiled
+/// </summary>
+/// <param name="localName">local name of added shader information</param>
+/// <returns></returns>
+inline unsigned long long& HotReloadableShaders::GetBundleWriteTime(const char* localName)
+{
+	return mBundles.writeTimes[FindBundle(localName)];
+}
+
+/// <summary>
+/// Hash of preprocessed tokens of added bundle
+/// </summary>
+/// <param name="localName">local name of added shader information</param>
+/// <returns></returns>
+inline unsigned long long& HotReloadableShaders::GetBundleTokenHash(const char* localName)
+{
+	return mBundles.tokenHashes[FindBundle(localName)];
+}
+
+/// <summary>
+/// Included files of bundle
+/// </summary>
+/// <param name="localName">local name of added bundle</param>
+/// <returns>Included files and their write times</returns>
+inline std::map<std::string, unsigned long long>& HotReloadableShaders::GetBundleDependencies(const char* localName)
+{
+	return mBundles.dependencies[FindBundle(localName)];
+}
+
+/// <summary>
+/// Is shader of bundle created
+/// </summary>
+/// <param name="localName">local name of shader information</param>
+/// <returns></returns>
+inline bool HotReloadableShaders::HasCompiledShader(const char* localName)
+{
+	auto index = FindBundle(localName);
+	return index != InvalidBundleIndex && mBundles.primaryShaders[index];
+}
+
+/// <summary>
+/// Is shader changed after preprocess, comments and whitespaces is not count
+/// </summary>
+/// <param name="info">Shader information</param>
+/// <param name="preprocessed">Preprocessed shader</param>
+/// <returns>true if shader must be compiled</returns>
+inline bool HotReloadableShaders::IsPreprocessedShaderChanged(ShaderInformation& info, const PreprocessedShader& preprocessed)
+{
+	// Not compiled yet
+	if (!HasCompiledShader(info.localName))
+		return true;
+
+	return GetBundleTokenHash(info.localName) != preprocessed.tokenHash;
+}
+
+/// <summary>
+/// Subscribe bundle to compile service
+/// </summary>
+/// <param name="info">Shader information</param>
+/// <returns>true if message is queued</returns>
+inline bool HotReloadableShaders::SubscribeToCompileService(ShaderInformation& info)
+{
+	// Full path, service is shared by processes with different working directories
+	char fullPath[MAX_PATH] = {};
+	if (!GetFullPathNameA(info.hlslPath, MAX_PATH, fullPath, nullptr))
+		return false;
+
+	ShaderServiceMessage message;
+	message.PutUInt((unsigned int)info.localShaderType);
+	message.PutString(info.localName);
+	message.PutString(fullPath);
+	message.PutString(info.entryPoint);
+	message.PutString(GetShaderProfile(info));
+	message.PutUInt(HOT_RELOADABLE_SHADERS_COMPILE_FLAGS);
+	return mServiceWriter.Queue(message.Pack(ShaderServiceMessageType::Subscribe));
+}
+
+/// <summary>
+/// Take compile results from service, never blocks
+/// </summary>
+inline void HotReloadableShaders::ReceiveCompileServiceResults()
+{
+	ShaderTraceScope trace("ServiceReceive");
+
+	// Read all available bytes, they is in pipe already, so read is finished at once
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+	DWORD availableBytes = 0;
+	while (PeekNamedPipe(mServicePipe, nullptr, 0, nullptr, &availableBytes, nullptr) && availableBytes > 0)
+	{
+		std::vector<unsigned char> buffer(availableBytes);
+		DWORD bytesRead = 0;
+		ResetEvent(overlapped.hEvent);
+		BOOL isDone = ::ReadFile(mServicePipe, buffer.data(), availableBytes, NULL, &overlapped);
+		if ((!isDone && GetLastError() != ERROR_IO_PENDING) || !GetOverlappedResult(mServicePipe, &overlapped, &bytesRead, TRUE))
+			break;
+
+		mServiceReceiver.Append(buffer.data(), bytesRead);
+	}
+	CloseHandle(overlapped.hEvent);
+
+	ShaderServiceMessageType type;
+	ShaderServiceMessage message;
+	bool isPassStarted = false;
+	while (mServiceReceiver.Next(type, message))
+	{
+		if (type != ShaderServiceMessageType::Result)
+			continue;
+
+		std::string localName;
+		unsigned int isSucceeded = 0;
+		unsigned long long tokenHash = 0;
+		std::vector<unsigned char> bytecode;
+		std::string errorMessage;
+		if (!message.GetString(localName) || !message.GetUInt(isSucceeded) || !message.GetUInt64(tokenHash) ||
+			!message.GetBytes(bytecode) || !message.GetString(errorMessage))
+			continue;
+
+		auto info = GetShaderInformationByLocalName(localName.c_str());
+		if (!info)
+			continue;
+
+		if (!isSucceeded)
+		{
+			// Results of one receive is one pass
+			if (!isPassStarted)
+				GetShaderDiagnostics().BeginPass();
+			isPassStarted = true;
+
+			GetShaderDiagnostics().ReportCompilerOutput(info->localName, errorMessage.c_str());
+			continue;
+		}
+
+		// Same shader
+		auto& state = GetBundleState(info->localName);
+		if (HasCompiledShader(info->localName) && GetBundleTokenHash(info->localName) == tokenHash)
+			continue;
+
+		if (!CreateShader(*info, bytecode.data(), bytecode.size()))
+			continue;
+
+		GetBundleTokenHash(info->localName) = tokenHash;
+		state.iterationSource.reset();
+		if (info->bSaveToCSO)
+		{
+			GenerateCSO(*info, bytecode.data(), (int)bytecode.size());
+		}
+	}
+
+	// Service is closed, watch files locally
+	bool isBroken = mServiceReceiver.IsBroken() || mServiceWriter.IsBroken() ||
+		(!PeekNamedPipe(mServicePipe, nullptr, 0, nullptr, nullptr, nullptr) && GetLastError() == ERROR_BROKEN_PIPE);
+	if (isBroken)
+	{
+		GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Info, nullptr, nullptr, "Compile service is disconnected, files is watched locally");
+		DisconnectFromCompileService();
+	}
+}
+
+/// <summary>
+/// Close connection with service, local watching is used again
+/// </summary>
+inline void HotReloadableShaders::DisconnectFromCompileService()
+{
+	if (mServicePipe != INVALID_HANDLE_VALUE)
+	{
+		mServiceWriter.Stop();
+		CloseHandle(mServicePipe);
+		mServicePipe = INVALID_HANDLE_VALUE;
+	}
+}
+
+/// <summary>
+/// Create shaders for every device of bundle and replace old shaders
+/// Bytecode is compiled once, shaders is replaced only when they are created for all devices
+/// </summary>
+/// <param name="info">Shader information</param>
+/// <param name="bytecode">Compiled bytecode</param>
+/// <param name="bytecodeSize">Bytecode size</param>
+/// <param name="tier">Compile tier of bytecode</param>
+/// <returns></returns>
+inline bool HotReloadableShaders::CreateShader(ShaderInformation& info, const void* bytecode, size_t bytecodeSize, ShaderCompileTier tier)
+{
+	std::vector<IUnknown*> shaders;
+	if (!CreateShaderObjects(info, bytecode, bytecodeSize, shaders))
+		return false;
+
+	PublishShaderObjects(info, shaders, bytecode, bytecodeSize, tier);
+	return true;
+}
+
+/// <summary>
+/// Create shaders for every device of bundle, nothing is replaced
+/// </summary>
+/// <param name="info">Shader information</param>
+/// <param name="bytecode">Compiled bytecode</param>
+/// <param name="bytecodeSize">Bytecode size</param>
+/// <param name="shaders">out shaders, one per device</param>
+/// <returns>false if any shader is not created, then nothing is created</returns>
+inline bool HotReloadableShaders::CreateShaderObjects(ShaderInformation& info, const void* bytecode, size_t bytecodeSize, std::vector<IUnknown*>& shaders)
+{
+	ShaderTraceScope trace("CreateShader", info.localName);
+
+	auto& state = GetBundleState(info.localName);
+	auto& devices = state.devices;
+	shaders.assign(devices.size(), nullptr);
+	if (!state.stage)
+		return false;
+
+	for (size_t i = 0; i < devices.size(); i++)
+	{
+		bool isCreated = state.stage->create(devices[i].mRenderDevice, bytecode, bytecodeSize, &shaders[i]);
+		if (!isCreated)
+		{
+			for (auto shader : shaders)
+			{
+				if (shader)
+					shader->Release();
+			}
+			shaders.clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Publish new snapshot of shader table
+/// Readers is never blocked: they count themselves in epoch and take snapshot.
+/// Writer flips epoch twice and waits until readers of both epochs is gone, after it nobody can see old snapshot
+/// </summary>
+inline void HotReloadableShaders::PublishShaderTable()
+{
+	if (!bIsShaderTableChanged)
+		return;
+
+	bIsShaderTableChanged = false;
+	ShaderTraceScope trace("PublishShaderTable");
+
+	auto table = new ShaderTableSnapshot();
+	for (size_t index = 0; index < mBundles.informations.size(); index++)
+	{
+		auto& state = mBundles.states[index];
+		auto& entry = table->entries[mBundles.informations[index].localName];
+		entry.shaders = mBundles.shaders[index];
+		entry.isRequested = mBundles.requests[index];
+		entry.fallback = nullptr;
+		for (auto& devices : state.devices)
+			entry.devices.push_back(devices.mRenderDevice);
+	}
+
+	// Fallback of stage, nodes of map is not moved
+	for (auto& entry : table->entries)
+	{
+		auto info = GetShaderInformationByLocalName(entry.first.data());
+		auto fallback = info ? mLazyFallbacks.find(info->localShaderType) : mLazyFallbacks.end();
+		if (fallback == mLazyFallbacks.end() || fallback->second == entry.first)
+			continue;
+
+		auto fallbackEntry = table->entries.find(fallback->second);
+		if (fallbackEntry != table->entries.end())
+			entry.second.fallback = &fallbackEntry->second;
+	}
+
+	auto old = mShaderTable.exchange(table);
+
+	// Reader which has taken epoch long ago can be counted in any of them
+	for (int i = 0; i < 2; i++)
+	{
+		auto epoch = mShaderTableEpoch.fetch_add(1) & 1;
+		while (mShaderTableReaders[epoch].load() != 0)
+			std::this_thread::yield();
+	}
+
+	delete old;
+}
+
+/// <summary>
+/// Put replaced shader in retirement queue
+/// </summary>
+/// <param name="shader">Shader, can be nullptr</param>
+inline void HotReloadableShaders::RetireShader(IUnknown* shader)
+{
+	if (shader)
+		mRetiredShaders.push_back({ mFrameIndex, shader });
+}
+
+/// <summary>
+/// Release retired shaders which GPU is not using
+/// Queue is sorted by frame, so released shaders is always at front
+/// </summary>
+/// <param name="isAll">Release all, used by destructor</param>
+inline void HotReloadableShaders::ReleaseRetiredShaders(bool isAll)
+{
+	if (mRetiredShaders.empty())
+		return;
+
+	ShaderTraceScope trace("ReleaseRetired");
+	while (!mRetiredShaders.empty() && (isAll || mRetiredShaders.front().frameIndex + mReleaseLatency <= mFrameIndex))
+	{
+		mRetiredShaders.front().shader->Release();
+		mRetiredShaders.pop_front();
+	}
+}
+
+/// <summary>
+/// Replace old shaders of bundle by created
+/// </summary>
+/// <param name="info">Shader information</param>
+/// <param name="shaders">Created shaders, one per device, owned by bundle after call</param>
+/// <param name="bytecode">Compiled bytecode</param>
+/// <param name="bytecodeSize">Bytecode size</param>
+/// <param name="tier">Compile tier of bytecode</param>
+inline void HotReloadableShaders::PublishShaderObjects(ShaderInformation& info, std::vector<IUnknown*>& shaders, const void* bytecode, size_t bytecodeSize, ShaderCompileTier tier)
+{
+	// Replace old shaders, they can be used by frames in flight
+	auto index = FindBundle(info.localName);
+	auto& current = mBundles.shaders[index];
+	for (auto shader : current)
+		RetireShader(shader);
+	current = shaders;
+	bool wasCreated = mBundles.primaryShaders[index] != nullptr;
+	mBundles.primaryShaders[index] = shaders.empty() ? nullptr : shaders[0];
+	if (wasCreated != (mBundles.primaryShaders[index] != nullptr))
+		CountTagReadiness(index, 0, wasCreated ? -1 : 1, 0);
+	bIsShaderTableChanged = true;
+
+	// Bind new shaders on contexts of bundle
+	auto& state = GetBundleState(info.localName);
+	state.bytecode.assign((const unsigned char*)bytecode, (const unsigned char*)bytecode + bytecodeSize);
+	if (info.isAutomationBind)
+	{
+		for (size_t i = 0; i < shaders.size() && i < state.devices.size(); i++)
+		{
+			if (state.devices[i].mRenderDeviceContext)
+				state.stage->bind(state.devices[i].mRenderDeviceContext, shaders[i]);
+		}
+	}
+
+	mCompiledShaders.push_back({ info.localShaderType });
+	bIsCompiled = true;
+
+	state.tier = tier;
+	RecordShaderCost(info, bytecode, bytecodeSize, tier);
+}
+
+/// <summary>
+/// Format cost value with deltas
+/// </summary>
+/// <param name="name">Name of value</param>
+/// <param name="value">Current value</param>
+/// <param name="previous">Previous value, nullptr if there is no previous</param>
+/// <param name="baseline">Baseline value, nullptr if there is no baseline</param>
+/// <returns>String like "instructions 120 (+8 prev, +20 base)"</returns>
+inline std::string FormatShaderCostValue(const char* name, long long value, const long long* previous, const long long* baseline)
+{
+	char buffer[128] = {};
+	sprintf_s(buffer, sizeof(buffer), "%s %lld", name, value);
+	std::string result = buffer;
+
+	if (previous)
+	{
+		sprintf_s(buffer, sizeof(buffer), " (%+lld prev", value - *previous);
+		result += buffer;
+	}
+	if (baseline)
+	{
+		sprintf_s(buffer, sizeof(buffer), "%s%+lld base", previous ? ", " : " (", value - *baseline);
+		result += buffer;
+	}
+	if (previous || baseline)
+		result += ")";
+
+	return result;
+}
+
+/// <summary>
+/// Add cost of created shader in history and report deltas
+/// Deltas is counted from previous version of same tier (unoptimized shader is always bigger)
+/// </summary>
+/// <param name="info">Shader information</param>
+/// <param name="bytecode">Compiled bytecode</param>
+/// <param name="bytecodeSize">Bytecode size</param>
+/// <param name="tier">Compile tier of bytecode</param>
+inline void HotReloadableShaders::RecordShaderCost(ShaderInformation& info, const void* bytecode, size_t bytecodeSize, ShaderCompileTier tier)
+{
+	auto& state = GetBundleState(info.localName);
+
+	ShaderCostStatistics statistics = {};
+	statistics.generation = ++mBundles.generations[FindBundle(info.localName)];
+	statistics.tier = tier;
+	statistics.bytecodeSize = bytecodeSize;
+	if (!GetShaderReflectionInfo(bytecode, bytecodeSize, statistics.reflection))
+	{
+		// Stripped bytecode from archive, reflection is kept in entry
+		auto entry = mShaderArchive.IsOpen() ? mShaderArchive.Find(info.localName) : nullptr;
+		if (!entry || entry->bytecodeSize != bytecodeSize)
+			return;
+		statistics.reflection = entry->reflection;
+	}
+
+	// Previous version of same tier
+	const ShaderCostStatistics* previous = nullptr;
+	for (auto it = state.costHistory.rbegin(); it != state.costHistory.rend(); it++)
+	{
+		if (it->tier == tier)
+		{
+			previous = &*it;
+			break;
+		}
+	}
+	const ShaderCostStatistics* baseline = state.hasCostBaseline && state.costBaseline.tier == tier ? &state.costBaseline : nullptr;
+
+	// Report
+	auto format = [&](const char* name, long long value, long long previousValue, long long baselineValue) {
+		return FormatShaderCostValue(name, value, previous ? &previousValue : nullptr, baseline ? &baselineValue : nullptr);
+	};
+	auto& current = statistics.reflection;
+	auto& previousReflection = previous ? previous->reflection : current;
+	auto& baselineReflection = baseline ? baseline->reflection : current;
+
+	// First version of tier or same cost is not written, console is not flooded by startup and edits which don't change cost
+	bool isChanged = previous && (current.instructionCount != previousReflection.instructionCount ||
+		current.tempRegisterCount != previousReflection.tempRegisterCount ||
+		current.textureInstructionCount != previousReflection.textureInstructionCount ||
+		current.aluInstructionCount != previousReflection.aluInstructionCount ||
+		bytecodeSize != previous->bytecodeSize);
+
+	std::string message = std::string("Generation ") + std::to_string(statistics.generation) +
+		(tier == ShaderCompileTier::Iteration ? " (iteration): " : ": ") +
+		format("instructions", current.instructionCount, previousReflection.instructionCount, baselineReflection.instructionCount) + ", " +
+		format("temps", current.tempRegisterCount, previousReflection.tempRegisterCount, baselineReflection.tempRegisterCount) + ", " +
+		format("texture", current.textureInstructionCount, previousReflection.textureInstructionCount, baselineReflection.textureInstructionCount) + ", " +
+		format("alu", current.aluInstructionCount, previousReflection.aluInstructionCount, baselineReflection.aluInstructionCount) + ", " +
+		format("bytes", (long long)bytecodeSize, previous ? (long long)previous->bytecodeSize : 0, baseline ? (long long)baseline->bytecodeSize : 0);
+	if (isChanged || bIsCostReportOfEveryGeneration)
+		GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Info, info.localName, info.hlslPath, message.c_str());
+
+	// Budget, only for optimized shaders
+	auto& budget = state.costBudget;
+	if (tier == ShaderCompileTier::Optimized)
+	{
+		std::string overBudget;
+		auto check = [&](const char* name, unsigned long long value, unsigned long long limit) {
+			if (limit && value > limit)
+				overBudget += std::string(overBudget.empty() ? "" : ", ") + name + " " + std::to_string(value) + " > " + std::to_string(limit);
+		};
+		check("instructions", current.instructionCount, budget.maxInstructionCount);
+		check("temps", current.tempRegisterCount, budget.maxTempRegisterCount);
+		check("texture", current.textureInstructionCount, budget.maxTextureInstructionCount);
+		check("alu", current.aluInstructionCount, budget.maxAluInstructionCount);
+		check("bytes", bytecodeSize, budget.maxBytecodeSize);
+
+		if (!overBudget.empty())
+		{
+			overBudget = "Shader is over cost budget: " + overBudget;
+			GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Warning, info.localName, info.hlslPath, overBudget.c_str());
+		}
+	}
+
+	// Bounded history
+	state.costHistory.push_back(statistics);
+	while (state.costHistory.size() > mCostHistorySize)
+		state.costHistory.pop_front();
+}
+
+/// <summary>
+/// Create shader of stage
+/// </summary>
+/// <param name="device">Device</param>
+/// <param name="bytecode">Compiled bytecode</param>
+/// <param name="bytecodeSize">Bytecode size</param>
+/// <param name="shader">out shader</param>
+/// <returns>true if shader is created</returns>
+template<HotReloadableShaderType Type>
+inline bool CreateStageShader(ID3D11Device* device, const void* bytecode, size_t bytecodeSize, IUnknown** shader)
+{
+	if (!device)
+		return false;
+
+	typename ShaderStageTraits<Type>::Interface* created = nullptr;
+	auto res = (device->*ShaderStageTraits<Type>::create)(bytecode, bytecodeSize, nullptr, &created);
+	if (FAILED(res))
+	{
+		return false;
+	}
+
+	*shader = created;
+	return true;
+}
+
+/// <summary>
+/// Bind shader of stage
+/// </summary>
+/// <param name="context">Device context</param>
+/// <param name="shader">Shader created by CreateStageShader of same stage</param>
+template<HotReloadableShaderType Type>
+inline void BindStageShader(ID3D11DeviceContext* context, IUnknown* shader)
+{
+	(context->*ShaderStageTraits<Type>::bind)(static_cast<typename ShaderStageTraits<Type>::Interface*>(shader), nullptr, 0);
+}
+
+/// <summary>
+/// Functions of stage, generated from traits
+/// </summary>
+template<HotReloadableShaderType Type>
+constexpr ShaderStageFunctions MakeShaderStageFunctions()
+{
+	return { &CreateStageShader<Type>, &BindStageShader<Type>, ShaderStageTraits<Type>::defaultProfile };
+}
+
+/// <summary>
+/// Functions of stage
+/// </summary>
+/// <param name="type">Stage</param>
+/// <returns>Functions, nullptr for unknown type</returns>
+inline const ShaderStageFunctions* GetShaderStageFunctions(HotReloadableShaderType type)
+{
+	// Same order as HotReloadableShaderType
+	static constexpr ShaderStageFunctions functions[] =
+	{
+		MakeShaderStageFunctions<HotReloadableShaderType::VertexShader>(),
+		MakeShaderStageFunctions<HotReloadableShaderType::PixelShader>(),
+		MakeShaderStageFunctions<HotReloadableShaderType::GeometryShader>(),
+		MakeShaderStageFunctions<HotReloadableShaderType::HullShader>(),
+		MakeShaderStageFunctions<HotReloadableShaderType::DomainShader>(),
+		MakeShaderStageFunctions<HotReloadableShaderType::ComputeShader>(),
+	};
+
+	auto index = (size_t)type;
+	return index < sizeof(functions) / sizeof(functions[0]) ? &functions[index] : nullptr;
+}
+
+/// <summary>
+/// Compile profile of bundle
+/// </summary>
+/// <param name="info">Shader information</param>
+/// <returns>shaderVersion, or default profile of stage when it is not set</returns>
+inline const char* GetShaderProfile(const ShaderInformation& info)
+{
+	if (info.shaderVersion && info.shaderVersion[0])
+		return info.shaderVersion;
+
+	auto stage = GetShaderStageFunctions(info.localShaderType);
+	return stage ? stage->defaultProfile : "";
+}
+
+
+/// <summary>
+/// Compress one block (LZ4 block format)
+/// </summary>
+/// <param name="source">Source bytes</param>
+/// <param name="sourceSize">Source size</param>
+/// <param name="compressed">out compressed bytes are appended</param>
+inline void CompressShaderBlock(const unsigned char* source, size_t sourceSize, std::vector<unsigned char>& compressed)
+{
+	constexpr size_t minMatch = 4;
+	constexpr size_t lastLiterals = 5;
+	constexpr size_t matchFindLimit = 12;
+	constexpr unsigned int hashBits = 12;
+
+	auto read32 = [source](size_t offset) {
+		unsigned int value;
+		memcpy(&value, source + offset, sizeof(value));
+		return value;
+	};
+	auto writeLength = [&compressed](size_t length) {
+		for (; length >= 255; length -= 255)
+			compressed.push_back(255);
+		compressed.push_back((unsigned char)length);
+	};
+	auto writeSequence = [&](size_t literalStart, size_t literalLength, size_t offset, size_t matchLength) {
+		auto token = compressed.size();
+		compressed.push_back((unsigned char)((literalLength < 15 ? literalLength : 15) << 4));
+		if (literalLength >= 15)
+			writeLength(literalLength - 15);
+		compressed.insert(compressed.end(), source + literalStart, source + literalStart + literalLength);
+
+		// Last sequence has only literals
+		if (!matchLength)
+			return;
+
+		compressed.push_back((unsigned char)(offset & 0xFF));
+		compressed.push_back((unsigned char)(offset >> 8));
+		matchLength -= minMatch;
+		compressed[token] |= (unsigned char)(matchLength < 15 ? matchLength : 15);
+		if (matchLength >= 15)
+			writeLength(matchLength - 15);
+	};
+
+	size_t anchor = 0;
+	if (sourceSize > matchFindLimit)
+	{
+		// Position + 1 of last sequence with same hash, 0 - empty
+		std::vector<unsigned int> table(1u << hashBits, 0);
+		auto matchLimit = sourceSize - lastLiterals;
+		auto inputLimit = sourceSize - matchFindLimit;
+
+		size_t position = 0;
+		while (position < inputLimit)
+		{
+			auto sequence = read32(position);
+			auto hash = (sequence * 2654435761u) >> (32 - hashBits);
+			size_t reference = table[hash];
+			table[hash] = (unsigned int)(position + 1);
+
+			if (!reference || position - (reference - 1) > 65535 || read32(reference - 1) != sequence)
+			{
+				position++;
+				continue;
+			}
+			reference--;
+
+			// Extend match backward and forward
+			while (position > anchor && reference > 0 && source[position - 1] == source[reference - 1])
+			{
+				position--;
+				reference--;
+			}
+			auto length = minMatch;
+			while (position + length < matchLimit && source[reference + length] == source[position + length])
+				length++;
+
+			writeSequence(anchor, position - anchor, position - reference, length);
+			position += length;
+			anchor = position;
+		}
+	}
+
+	writeSequence(anchor, sourceSize - anchor, 0, 0);
+}
+
+/// <summary>
+/// Decompress one block (LZ4 block format), every offset and length is checked
+/// </summary>
+/// <param name="source">Compressed bytes</param>
+/// <param name="sourceSize">Compressed size</param>
+/// <param name="destination">Output</param>
+/// <param name="destinationSize">Size of output</param>
+/// <returns>Count of decompressed bytes, 0 if block is broken</returns>
+inline size_t DecompressShaderBlock(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationSize)
+{
+	size_t input = 0;
+	size_t output = 0;
+
+	auto readLength = [&](size_t& length) {
+		unsigned char value = 255;
+		while (value == 255)
+		{
+			if (input >= sourceSize)
+				return false;
+			value = source[input++];
+			length += value;
+		}
+		return true;
+	};
+
+	while (input < sourceSize)
+	{
+		auto token = source[input++];
+
+		size_t literalLength = token >> 4;
+		if (literalLength == 15 && !readLength(literalLength))
+			return 0;
+		if (literalLength > sourceSize - input || literalLength > destinationSize - output)
+			return 0;
+
+		memcpy(destination + output, source + input, literalLength);
+		input += literalLength;
+		output += literalLength;
+
+		// Last sequence
+		if (input == sourceSize)
+			return output;
+
+		if (sourceSize - input < 2)
+			return 0;
+		size_t offset = source[input] | (source[input + 1] << 8);
+		input += 2;
+		if (offset == 0 || offset > output)
+			return 0;
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !readLength(matchLength))
+			return 0;
+		matchLength += 4;
+		if (matchLength > destinationSize - output)
+			return 0;
+
+		// Match can overlap output
+		auto match = destination + output - offset;
+		for (size_t i = 0; i < matchLength; i++)
+			destination[output + i] = match[i];
+		output += matchLength;
+	}
+
+	return 0;
+}
+
+/// <summary>
+/// Compress bytes in stream of independent blocks, so stream can be decompressed block by block while it is read.
+/// Every block is prefixed by 32-bit size, high bit - block is stored without compression
+/// </summary>
+/// <param name="data">Bytes</param>
+/// <param name="size">Size</param>
+/// <param name="compressed">out compressed stream</param>
+inline void CompressShaderBytes(const void* data, size_t size, std::vector<unsigned char>& compressed)
+{
+	compressed.clear();
+
+	auto bytes = (const unsigned char*)data;
+	std::vector<unsigned char> block;
+	for (size_t offset = 0; offset < size; offset += ShaderCompressionBlockSize)
+	{
+		auto blockSize = std::min(ShaderCompressionBlockSize, size - offset);
+		block.clear();
+		CompressShaderBlock(bytes + offset, blockSize, block);
+
+		// Incompressible block is stored
+		bool isStored = block.size() >= blockSize;
+		unsigned int header = isStored ? (unsigned int)blockSize | ShaderCompressionStoredBlock : (unsigned int)block.size();
+		compressed.insert(compressed.end(), (const unsigned char*)&header, (const unsigned char*)&header + sizeof(header));
+		if (isStored)
+			compressed.insert(compressed.end(), bytes + offset, bytes + offset + blockSize);
+		else
+			compressed.insert(compressed.end(), block.begin(), block.end());
+	}
+}
+
+/// <summary>
+/// Decompress one block of stream
+/// </summary>
+/// <param name="header">Header of block</param>
+/// <param name="block">Bytes of block</param>
+/// <param name="destination">Output</param>
+/// <param name="destinationSize">Free size of output</param>
+/// <returns>Count of decompressed bytes, 0 if block is broken</returns>
+inline size_t DecompressShaderStreamBlock(unsigned int header, const unsigned char* block, unsigned char* destination, size_t destinationSize)
+{
+	auto blockSize = (size_t)(header & ~ShaderCompressionStoredBlock);
+	if (!(header & ShaderCompressionStoredBlock))
+		return DecompressShaderBlock(block, blockSize, destination, std::min(destinationSize, ShaderCompressionBlockSize));
+
+	if (blockSize > destinationSize || blockSize > ShaderCompressionBlockSize)
+		return 0;
+
+	memcpy(destination, block, blockSize);
+	return blockSize;
+}
+
+/// <summary>
+/// Decompress stream from memory
+/// </summary>
+/// <param name="data">Compressed stream</param>
+/// <param name="size">Size of compressed stream</param>
+/// <param name="destination">Output</param>
+/// <param name="destinationSize">Size of decompressed bytes</param>
+/// <returns>true if all bytes is decompressed</returns>
+inline bool DecompressShaderBytes(const void* data, size_t size, void* destination, size_t destinationSize)
+{
+	auto input = (const unsigned char*)data;
+	auto output = (unsigned char*)destination;
+	size_t inputOffset = 0;
+	size_t outputOffset = 0;
+
+	while (inputOffset < size)
+	{
+		unsigned int header = 0;
+		if (size - inputOffset < sizeof(header))
+			return false;
+		memcpy(&header, input + inputOffset, sizeof(header));
+		inputOffset += sizeof(header);
+
+		auto blockSize = (size_t)(header & ~ShaderCompressionStoredBlock);
+		if (blockSize > size - inputOffset)
+			return false;
+
+		auto decoded = DecompressShaderStreamBlock(header, input + inputOffset, output + outputOffset, destinationSize - outputOffset);
+		if (!decoded)
+			return false;
+
+		inputOffset += blockSize;
+		outputOffset += decoded;
+	}
+
+	return outputOffset == destinationSize;
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+inline ShaderCache::ShaderCache()
+{
+}
+
+/// <summary>
+/// Set cache directory, if directory is not exist - it will be created
+/// </summary>
+/// <param name="directory">Cache directory, nullptr - disable cache</param>
+inline void ShaderCache::SetDirectory(const char* directory)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mDirectory = directory ? directory : "";
+	if (mDirectory.empty())
+		return;
+
+	// Remove last slash
+	if (mDirectory.back() == '/' || mDirectory.back() == '\\')
+		mDirectory.pop_back();
+
+	CreateDirectoryA(mDirectory.c_str(), nullptr);
+}
+
+/// <summary>
+/// Is cache enabled
+/// </summary>
+/// <returns></returns>
+inline bool ShaderCache::IsEnabled()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return !mDirectory.empty();
+}
+
+/// <summary>
+/// Get path to cache file
+/// </summary>
+/// <param name="key">Compile key</param>
+/// <returns>Path to cache file</returns>
+inline std::string ShaderCache::GetEntryPath(unsigned long long key)
+{
+	char name[32] = {};
+	sprintf_s(name, sizeof(name), "%016llx.hrsc", key);
+	return mDirectory + "/" + name;
+}
+
+// Cache entry header
+struct ShaderCacheEntryHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned long long key;
+	unsigned long long bytecodeSize;
+	unsigned long long storedSize;
+};
+
+constexpr unsigned int ShaderCacheMagic = 0x43535248; // "HRSC"
+constexpr unsigned int ShaderCacheVersion = 2;
+
+/// <summary>
+/// Try load bytecode by compile key
+/// </summary>
+/// <param name="key">Compile key</param>
+/// <param name="bytecode">out bytecode</param>
+/// <returns>true if entry is found</returns>
+inline bool ShaderCache::Load(unsigned long long key, std::vector<unsigned char>& bytecode)
+{
+	std::string path;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mDirectory.empty())
+			return false;
+		path = GetEntryPath(key);
+	}
+
+	FILE* f = nullptr;
+	fopen_s(&f, path.c_str(), "rb");
+	if (!f)
+		return false;
+
+	// Validate entry, file can be broken or from other version
+	ShaderCacheEntryHeader header = {};
+	if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != ShaderCacheMagic ||
+		header.version != ShaderCacheVersion || header.key != key || header.bytecodeSize == 0)
+	{
+		fclose(f);
+		return false;
+	}
+
+	// Sizes is checked by size of file before memory is allocated:
+	// blocks is taken all rest of file, every block is at least header and one byte and is decoded in not more than block size
+	long fileSize = -1;
+	if (fseek(f, 0, SEEK_END) == 0)
+		fileSize = ftell(f);
+	if (fileSize < (long)sizeof(header) || header.storedSize != (unsigned long long)fileSize - sizeof(header) ||
+		header.bytecodeSize > header.storedSize / (sizeof(unsigned int) + 1) * ShaderCompressionBlockSize ||
+		fseek(f, (long)sizeof(header), SEEK_SET) != 0)
+	{
+		fclose(f);
+		return false;
+	}
+
+	// Decompress block by block while it is read
+	bytecode.resize((size_t)header.bytecodeSize);
+	std::vector<unsigned char> block;
+	size_t offset = 0;
+	unsigned long long storedSize = 0;
+	bool isLoaded = true;
+	while (isLoaded && offset < bytecode.size())
+	{
+		unsigned int blockHeader = 0;
+		isLoaded = fread(&blockHeader, sizeof(blockHeader), 1, f) == 1;
+		if (!isLoaded)
+			break;
+
+		// Size of block is checked before it is allocated, header can be broken
+		auto blockSize = (size_t)(blockHeader & ~ShaderCompressionStoredBlock);
+		isLoaded = blockSize <= ShaderCompressionBlockSize && storedSize + sizeof(blockHeader) + blockSize <= header.storedSize;
+		if (!isLoaded)
+			break;
+
+		block.resize(blockSize);
+		isLoaded = fread(block.data(), 1, block.size(), f) == block.size();
+		if (!isLoaded)
+			break;
+
+		auto decoded = DecompressShaderStreamBlock(blockHeader, block.data(), bytecode.data() + offset, bytecode.size() - offset);
+		isLoaded = decoded != 0;
+		offset += decoded;
+		storedSize += sizeof(blockHeader) + block.size();
+	}
+	fclose(f);
+
+	if (!isLoaded || storedSize != header.storedSize)
+	{
+		bytecode.clear();
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Store bytecode by compile key
+/// </summary>
+/// <param name="key">Compile key</param>
+/// <param name="bytecode">Bytecode</param>
+/// <param name="bytecodeSize">Bytecode size</param>
+/// <returns>true if entry is written</returns>
+inline bool ShaderCache::Store(unsigned long long key, const void* bytecode, size_t bytecodeSize)
+{
+	std::string path;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mDirectory.empty())
+			return false;
+		path = GetEntryPath(key);
+	}
+
+	// Write in temp file and rename it, so other process never read half of entry
+	char suffix[32] = {};
+	sprintf_s(suffix, sizeof(suffix), ".%lu.tmp", GetCurrentThreadId());
+	std::string tempPath = path + suffix;
+
+	std::vector<unsigned char> compressed;
+	CompressShaderBytes(bytecode, bytecodeSize, compressed);
+
+	FILE* f = nullptr;
+	fopen_s(&f, tempPath.c_str(), "wb");
+	if (!f)
+		return false;
+
+	ShaderCacheEntryHeader header = {};
+	header.magic = ShaderCacheMagic;
+	header.version = ShaderCacheVersion;
+	header.key = key;
+	header.bytecodeSize = bytecodeSize;
+	header.storedSize = compressed.size();
+
+	bool isWritten = fwrite(&header, sizeof(header), 1, f) == 1 &&
+		fwrite(compressed.data(), 1, compressed.size(), f) == compressed.size();
+	fclose(f);
+
+	if (!isWritten || !MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileA(tempPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+/// <param name="threadCount">Count of worker threads, 0 - use all hardware threads</param>
+inline ShaderJobScheduler::ShaderJobScheduler(unsigned int threadCount)
+{
+	mActiveJobs = 0;
+	bIsStopping = false;
+
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+
+	mMaxConcurrency = threadCount;
+	mThrottle = threadCount;
+	mPriority = THREAD_PRIORITY_NORMAL;
+	mAffinityMask = 0;
+	mSettingsGeneration = 0;
+
+	mCompletedJobs = 0;
+	mBusyTime = {};
+	mStatisticsTime = std::chrono::steady_clock::now();
+	mJobStarts.resize(threadCount);
+
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		mWorkers.emplace_back([this, i]() { WorkerLoop(i); });
+	}
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+inline ShaderJobScheduler::~ShaderJobScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		bIsStopping = true;
+	}
+	mJobAvailable.notify_all();
+
+	for (auto& worker : mWorkers)
+	{
+		if (worker.joinable())
+			worker.join();
+	}
+}
+
+/// <summary>
+/// Add new job in queue
+/// </summary>
+/// <param name="job">Job</param>
+inline void ShaderJobScheduler::Submit(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mJobs.push_back(std::move(job));
+	}
+	mJobAvailable.notify_one();
+}
+
+/// <summary>
+/// Wait until all jobs is done
+/// </summary>
+inline void ShaderJobScheduler::Wait()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mJobsDone.wait(lock, [this]() { return mJobs.empty() && mActiveJobs == 0; });
+}
+
+/// <summary>
+/// Get count of worker threads
+/// </summary>
+/// <returns></returns>
+inline unsigned int ShaderJobScheduler::GetThreadCount()
+{
+	return (unsigned int)mWorkers.size();
+}
+
+/// <summary>
+/// Max count of jobs which run at once
+/// </summary>
+/// <param name="count">Count of jobs, 0 - count of threads</param>
+inline void ShaderJobScheduler::SetMaxConcurrency(unsigned int count)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mMaxConcurrency = count ? std::min(count, GetThreadCount()) : GetThreadCount();
+	}
+	mJobAvailable.notify_all();
+}
+
+/// <summary>
+/// Jobs which run at once under frame pressure
+/// Running jobs is not stopped, new jobs is not started until count of active jobs is below throttle
+/// </summary>
+/// <param name="count">Count of jobs, at least 1 job is running so reload is never stopped</param>
+inline void ShaderJobScheduler::SetThrottle(unsigned int count)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mThrottle = std::max(count, 1u);
+	}
+	mJobAvailable.notify_all();
+}
+
+/// <summary>
+/// OS priority of worker threads
+/// </summary>
+/// <param name="priority">THREAD_PRIORITY_*</param>
+inline void ShaderJobScheduler::SetThreadPriority(int priority)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mPriority = priority;
+	mSettingsGeneration++;
+}
+
+/// <summary>
+/// CPU affinity of worker threads
+/// </summary>
+/// <param name="mask">Mask of CPUs, 0 - all CPUs of process</param>
+inline void ShaderJobScheduler::SetAffinityMask(unsigned long long mask)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mAffinityMask = mask;
+	mSettingsGeneration++;
+}
+
+/// <summary>
+/// Count of jobs which can run at once
+/// </summary>
+/// <returns></returns>
+inline unsigned int ShaderJobScheduler::GetConcurrency()
+{
+	return std::max(std::min(mMaxConcurrency, mThrottle), 1u);
+}
+
+/// <summary>
+/// Queue depth and utilization
+/// </summary>
+/// <returns>Statistics, utilization is counted since previous call</returns>
+inline ShaderSchedulerStatistics ShaderJobScheduler::GetStatistics()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	ShaderSchedulerStatistics statistics = {};
+	statistics.threadCount = GetThreadCount();
+	statistics.concurrency = GetConcurrency();
+	statistics.queueDepth = (unsigned int)mJobs.size();
+	statistics.activeJobs = mActiveJobs;
+	statistics.completedJobs = mCompletedJobs;
+
+	// Running jobs is counted until now
+	auto now = std::chrono::steady_clock::now();
+	auto busyTime = mBusyTime;
+	for (auto& start : mJobStarts)
+	{
+		if (start != std::chrono::steady_clock::time_point())
+		{
+			busyTime += now - std::max(start, mStatisticsTime);
+			start = now;
+		}
+	}
+
+	auto time = std::chrono::duration<double>(now - mStatisticsTime).count() * statistics.threadCount;
+	statistics.utilization = time > 0.0 ? std::min(std::chrono::duration<double>(busyTime).count() / time, 1.0) : 0.0;
+
+	mBusyTime = {};
+	mStatisticsTime = now;
+	return statistics;
+}
+
+/// <summary>
+/// Worker thread loop
+/// </summary>
+/// <param name="index">Index of worker</param>
+inline void ShaderJobScheduler::WorkerLoop(unsigned int index)
+{
+	unsigned int settingsGeneration = 0;
+
+	while (true)
+	{
+		std::function<void()> job;
+		int priority = THREAD_PRIORITY_NORMAL;
+		unsigned long long affinityMask = 0;
+		bool isSettingsChanged = false;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mJobAvailable.wait(lock, [this]() { return bIsStopping || (!mJobs.empty() && mActiveJobs < GetConcurrency()); });
+			if (bIsStopping && mJobs.empty())
+				return;
+
+			job = std::move(mJobs.front());
+			mJobs.pop_front();
+			mActiveJobs++;
+			mJobStarts[index] = std::chrono::steady_clock::now();
+
+			isSettingsChanged = settingsGeneration != mSettingsGeneration;
+			settingsGeneration = mSettingsGeneration;
+			priority = mPriority;
+			affinityMask = mAffinityMask;
+		}
+
+		// Thread settings is applied by worker itself
+		if (isSettingsChanged)
+		{
+			::SetThreadPriority(GetCurrentThread(), priority);
+
+			DWORD_PTR processMask = 0;
+			DWORD_PTR systemMask = 0;
+			if (!affinityMask && GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+				affinityMask = processMask;
+			if (affinityMask)
+				SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)affinityMask);
+		}
+
+		job();
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mActiveJobs--;
+			mCompletedJobs++;
+			mBusyTime += std::chrono::steady_clock::now() - std::max(mJobStarts[index], mStatisticsTime);
+			mJobStarts[index] = {};
+		}
+		mJobsDone.notify_all();
+
+		// Slot is free for other worker
+		mJobAvailable.notify_one();
+	}
+}
+
+/// <summary>
+/// Get reflection metadata of compiled shader
+/// </summary>
+/// <param name="bytecode">Bytecode</param>
+/// <param name="bytecodeSize">Bytecode size</param>
+/// <param name="reflectionInfo">out reflection metadata</param>
+/// <returns>true if bytecode is reflected</returns>
+inline bool GetShaderReflectionInfo(const void* bytecode, size_t bytecodeSize, ShaderReflectionInfo& reflectionInfo)
+{
+	reflectionInfo = {};
+
+	ID3D11ShaderReflection* reflection = nullptr;
+	auto hr = D3DReflect(bytecode, bytecodeSize, __uuidof(ID3D11ShaderReflection), (void**)&reflection);
+	if (FAILED(hr))
+		return false;
+
+	D3D11_SHADER_DESC desc = {};
+	hr = reflection->GetDesc(&desc);
+	reflection->Release();
+	if (FAILED(hr))
+		return false;
+
+	reflectionInfo.instructionCount = desc.InstructionCount;
+	reflectionInfo.tempRegisterCount = desc.TempRegisterCount;
+	reflectionInfo.textureInstructionCount = desc.TextureNormalInstructions + desc.TextureLoadInstructions +
+		desc.TextureCompInstructions + desc.TextureBiasInstructions + desc.TextureGradientInstructions;
+	reflectionInfo.aluInstructionCount = desc.FloatInstructionCount + desc.IntInstructionCount + desc.UintInstructionCount;
+	reflectionInfo.constantBuffers = desc.ConstantBuffers;
+	reflectionInfo.boundResources = desc.BoundResources;
+	reflectionInfo.inputParameters = desc.InputParameters;
+	reflectionInfo.outputParameters = desc.OutputParameters;
+	return true;
+}
+
+/// <summary>
+/// Remove debug info, reflection and private data from bytecode
+/// Signatures is kept, so input layouts can be created from stripped vertex shader
+/// </summary>
+/// <param name="bytecode">Bytecode</param>
+/// <param name="bytecodeSize">Bytecode size</param>
+/// <param name="stripped">out stripped bytecode</param>
+/// <returns>true if bytecode is stripped</returns>
+inline bool StripShaderBytecode(const void* bytecode, size_t bytecodeSize, std::vector<unsigned char>& stripped)
+{
+	ID3DBlob* blob = nullptr;
+	auto hr = D3DStripShader(bytecode, bytecodeSize, D3DCOMPILER_STRIP_REFLECTION_DATA | D3DCOMPILER_STRIP_DEBUG_INFO |
+		D3DCOMPILER_STRIP_TEST_BLOBS | D3DCOMPILER_STRIP_PRIVATE_DATA, &blob);
+	if (FAILED(hr) || !blob)
+		return false;
+
+	auto data = (const unsigned char*)blob->GetBufferPointer();
+	stripped.assign(data, data + blob->GetBufferSize());
+	blob->Release();
+	return true;
+}
+
+constexpr unsigned int ShaderArchiveMagic = 0x41535248; // "HRSA"
+constexpr unsigned int ShaderArchiveVersion = 4;
+
+// Bytecode in archive is aligned for direct use
+constexpr unsigned long long ShaderArchiveAlignment = 16;
+
+/// <summary>
+/// Constructor
+/// </summary>
+inline ShaderArchiveWriter::ShaderArchiveWriter()
+{
+	bIsStripMode = false;
+	bIsCompression = true;
+}
+
+/// <summary>
+/// Strip debug info and reflection from bytecode
+/// </summary>
+/// <param name="isEnabled">Is enabled</param>
+inline void ShaderArchiveWriter::SetStripMode(bool isEnabled)
+{
+	bIsStripMode = isEnabled;
+}
+
+/// <summary>
+/// Compress bytecode
+/// </summary>
+/// <param name="isEnabled">Is enabled</param>
+inline void ShaderArchiveWriter::SetCompression(bool isEnabled)
+{
+	bIsCompression = isEnabled;
+}
+
+/// <summary>
+/// Add compiled shader
+/// </summary>
+/// <param name="info">Shader information</param>
+/// <param name="preprocessed">Preprocessed shader</param>
+/// <param name="source">HashBytes of .hlsl content which is compiled, size and write time of it</param>
+/// <param name="bytecode">Compiled bytecode</param>
+inline void ShaderArchiveWriter::Add(const ShaderInformation& info, const PreprocessedShader& preprocessed, const ShaderArchiveFile& source, const std::vector<unsigned char>& bytecode)
+{
+	PendingEntry pending = {};
+	pending.localName = info.localName;
+
+	// Entry is validated by content, paths inside directory of .hlsl is stored relative to it
+	std::string sourcePath = info.hlslPath;
+	auto slash = sourcePath.find_last_of("/\\");
+	auto sourceDirectory = slash == std::string::npos ? std::string() : sourcePath.substr(0, slash + 1);
+	for (auto& dependency : preprocessed.dependencies)
+	{
+		PendingDependency pendingDependency = {};
+		pendingDependency.path = dependency.first;
+
+		std::vector<unsigned char> content;
+		if (ReadFile(dependency.first.c_str(), content))
+		{
+			pendingDependency.file.contentHash = HashBytes(content.data(), content.size());
+			pendingDependency.file.size = content.size();
+			GetFileWriteTime(dependency.first.c_str(), pendingDependency.file.writeTime);
+		}
+
+		if (!sourceDirectory.empty() && !dependency.first.compare(0, sourceDirectory.size(), sourceDirectory))
+		{
+			pendingDependency.path = dependency.first.substr(sourceDirectory.size());
+			pendingDependency.flags = ShaderArchiveDependencyRelative;
+		}
+		pending.dependencies.push_back(pendingDependency);
+	}
+	pending.bytecode = bytecode;
+
+	auto& entry = pending.entry;
+	entry.nameHash = HashBytes(info.localName, strlen(info.localName));
+	entry.tokenHash = preprocessed.tokenHash;
+	entry.compileKey = GetShaderCompileKey(info, preprocessed.tokenHash);
+	entry.source = source;
+	entry.bytecodeSize = (unsigned int)bytecode.size();
+	entry.shaderType = (unsigned int)info.localShaderType;
+	GetShaderReflectionInfo(bytecode.data(), bytecode.size(), entry.reflection);
+
+	// Reflection is already read
+	std::vector<unsigned char> stripped;
+	if (bIsStripMode && StripShaderBytecode(bytecode.data(), bytecode.size(), stripped))
+		pending.bytecode.swap(stripped);
+	entry.bytecodeSize = (unsigned int)pending.bytecode.size();
+
+	// Keep compressed bytecode only if it is smaller
+	std::vector<unsigned char> compressed;
+	if (bIsCompression)
+		CompressShaderBytes(pending.bytecode.data(), pending.bytecode.size(), compressed);
+	if (!compressed.empty() && compressed.size() < pending.bytecode.size())
+		pending.bytecode.swap(compressed);
+	entry.storedSize = (unsigned int)pending.bytecode.size();
+
+	mEntries.push_back(pending);
+}
+
+/// <summary>
+/// Write archive in file
+/// Layout: header, sorted entries, dependencies, strings, aligned bytecode
+/// </summary>
+/// <param name="path">Path to archive</param>
+/// <returns>true if archive is written</returns>
+inline bool ShaderArchiveWriter::Write(const char* path)
+{
+	std::sort(mEntries.begin(), mEntries.end(), [](const PendingEntry& a, const PendingEntry& b) { return a.entry.nameHash < b.entry.nameHash; });
+
+	// Build tables
+	std::vector<ShaderArchiveEntry> entries;
+	std::vector<ShaderArchiveDependency> dependencies;
+	std::string strings;
+	std::map<std::string, unsigned int> stringOffsets;
+
+	auto addString = [&](const std::string& value) {
+		auto found = stringOffsets.find(value);
+		if (found != stringOffsets.end())
+			return found->second;
+
+		auto offset = (unsigned int)strings.size();
+		strings.append(value.c_str(), value.size() + 1);
+		stringOffsets[value] = offset;
+		return offset;
+	};
+
+	for (auto& pending : mEntries)
+	{
+		auto entry = pending.entry;
+		entry.nameOffset = addString(pending.localName);
+		entry.dependencyIndex = (unsigned int)dependencies.size();
+		entry.dependencyCount = (unsigned int)pending.dependencies.size();
+
+		for (auto& dependency : pending.dependencies)
+		{
+			ShaderArchiveDependency archiveDependency = {};
+			archiveDependency.file = dependency.file;
+			archiveDependency.pathOffset = addString(dependency.path);
+			archiveDependency.flags = dependency.flags;
+			dependencies.push_back(archiveDependency);
+		}
+
+		entries.push_back(entry);
+	}
+
+	auto align = [](unsigned long long value) { return (value + ShaderArchiveAlignment - 1) & ~(ShaderArchiveAlignment - 1); };
+
+	ShaderArchiveHeader header = {};
+	header.magic = ShaderArchiveMagic;
+	header.version = ShaderArchiveVersion;
+	header.entryCount = (unsigned int)entries.size();
+	header.dependencyCount = (unsigned int)dependencies.size();
+	header.entriesOffset = align(sizeof(header));
+	header.dependenciesOffset = align(header.entriesOffset + entries.size() * sizeof(ShaderArchiveEntry));
+	header.stringsOffset = align(header.dependenciesOffset + dependencies.size() * sizeof(ShaderArchiveDependency));
+	header.stringsSize = strings.size();
+
+	auto offset = align(header.stringsOffset + strings.size());
+	for (auto& entry : entries)
+	{
+		entry.bytecodeOffset = offset;
+		offset = align(offset + entry.storedSize);
+	}
+
+	// Write file
+	std::vector<unsigned char> file((size_t)offset, 0);
+	memcpy(file.data(), &header, sizeof(header));
+	if (!entries.empty())
+		memcpy(file.data() + header.entriesOffset, entries.data(), entries.size() * sizeof(ShaderArchiveEntry));
+	if (!dependencies.empty())
+		memcpy(file.data() + header.dependenciesOffset, dependencies.data(), dependencies.size() * sizeof(ShaderArchiveDependency));
+	if (!strings.empty())
+		memcpy(file.data() + header.stringsOffset, strings.data(), strings.size());
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		memcpy(file.data() + entries[i].bytecodeOffset, mEntries[i].bytecode.data(), entries[i].storedSize);
+	}
+
+	// Write in temp file and rename it, archive can be mapped by running application
+	std::string tempPath = std::string(path) + ".tmp";
+	FILE* f = nullptr;
+	fopen_s(&f, tempPath.c_str(), "wb");
+	if (!f)
+	{
+		GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Error, nullptr, path, "Failed create archive");
+		return false;
+	}
+
+	bool isWritten = fwrite(file.data(), 1, file.size(), f) == file.size();
+	fclose(f);
+
+	if (!isWritten || !MoveFileExA(tempPath.c_str(), path, MOVEFILE_REPLACE_EXISTING))
+	{
+		GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Error, nullptr, path, "Failed write archive");
+		DeleteFileA(tempPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+inline ShaderArchive::ShaderArchive()
+{
+	mFile = INVALID_HANDLE_VALUE;
+	mMapping = nullptr;
+	mData = nullptr;
+	mSize = 0;
+
+	mHeader = nullptr;
+	mEntries = nullptr;
+	mDependencies = nullptr;
+	mStrings = nullptr;
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+inline ShaderArchive::~ShaderArchive()
+{
+	Close();
+}
+
+/// <summary>
+/// Open and map archive
+/// </summary>
+/// <param name="path">Path to archive</param>
+/// <returns>true if archive is opened and valid</returns>
+inline bool ShaderArchive::Open(const char* path)
+{
+	Close();
+
+	mFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (mFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(mFile, &fileSize) || fileSize.QuadPart < (long long)sizeof(ShaderArchiveHeader))
+	{
+		Close();
+		return false;
+	}
+	mSize = (unsigned long long)fileSize.QuadPart;
+
+	mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mMapping)
+	{
+		Close();
+		return false;
+	}
+
+	mData = (const unsigned char*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+	if (!mData)
+	{
+		Close();
+		return false;
+	}
+
+	// Validate tables
+	mHeader = (const ShaderArchiveHeader*)mData;
+	bool isValid = mHeader->magic == ShaderArchiveMagic && mHeader->version == ShaderArchiveVersion &&
+		mHeader->entriesOffset + (unsigned long long)mHeader->entryCount * sizeof(ShaderArchiveEntry) <= mSize &&
+		mHeader->dependenciesOffset + (unsigned long long)mHeader->dependencyCount * sizeof(ShaderArchiveDependency) <= mSize &&
+		mHeader->stringsOffset + mHeader->stringsSize <= mSize &&
+		(mHeader->stringsSize == 0 || mData[mHeader->stringsOffset + mHeader->stringsSize - 1] == 0);
+	if (!isValid)
+	{
+		GetShaderDiagnostics().Report(ShaderDiagnosticSeverity::Error, nullptr, path, "Archive is broken or has other version");
+		Close();
+		return false;
+	}
+
+	mEntries = (const ShaderArchiveEntry*)(mData + mHeader->entriesOffset);
+	mDependencies = (const ShaderArchiveDependency*)(mData + mHeader->dependenciesOffset);
+	mStrings = (const char*)(mData + mHeader->stringsOffset);
+	return true;
+}
+
+/// <summary>
+/// Unmap archive
+/// </summary>
+inline void ShaderArchive::Close()
+{
+	if (mData)
+		UnmapViewOfFile(mData);
+	if (mMapping)
+		CloseHandle(mMapping);
+	if (mFile != INVALID_HANDLE_VALUE)
+		CloseHandle(mFile);
+
+	mFile = INVALID_HANDLE_VALUE;
+	mMapping = nullptr;
+	mData = nullptr;
+	mSize = 0;
+
+	mHeader = nullptr;
+	mEntries = nullptr;
+	mDependencies = nullptr;
+	mStrings = nullptr;
+}
+
+/// <summary>
+/// Is archive opened
+/// </summary>
+/// <returns></returns>
+inline bool ShaderArchive::IsOpen()
+{
+	return mHeader != nullptr;
+}
+
+/// <summary>
+/// Find entry by local name, O(log n)
+/// </summary>
+/// <param name="localName">Local name of shader information</param>
+/// <returns>Entry or nullptr</returns>
+inline const ShaderArchiveEntry* ShaderArchive::Find(const char* localName)
+{
+	if (!IsOpen())
+		return nullptr;
+
+	auto nameHash = HashBytes(localName, strlen(localName));
+	auto end = mEntries + mHeader->entryCount;
+	auto entry = std::lower_bound(mEntries, end, nameHash, [](const ShaderArchiveEntry& a, unsigned long long hash) { return a.nameHash < hash; });
+
+	// Hashes can be same for different names
+	for (; entry != end && entry->nameHash == nameHash; entry++)
+	{
+		auto name = GetString(entry->nameOffset);
+		if (name && !strcmp(name, localName))
+			return entry;
+	}
+
+	return nullptr;
+}
+
+/// <summary>
+/// Get bytecode of entry
+/// </summary>
+/// <param name="entry">Archive entry</param>
+/// <param name="buffer">Buffer for decompressed bytecode</param>
+/// <returns>Pointer in mapped archive or in buffer, nullptr if entry is broken</returns>
+inline const void* ShaderArchive::GetBytecode(const ShaderArchiveEntry* entry, std::vector<unsigned char>& buffer)
+{
+	if (!IsOpen() || entry->bytecodeOffset + entry->storedSize > mSize)
+		return nullptr;
+
+	// Not compressed, use mapped bytecode directly
+	if (entry->storedSize == entry->bytecodeSize)
+		return mData + entry->bytecodeOffset;
+
+	buffer.resize(entry->bytecodeSize);
+	if (!DecompressShaderBytes(mData + entry->bytecodeOffset, entry->storedSize, buffer.data(), buffer.size()))
+		return nullptr;
+
+	return buffer.data();
+}
+
+/// <summary>
+/// Get dependencies of entry
+/// </summary>
+/// <param name="entry">Archive entry</param>
+/// <returns>Pointer in mapped archive or nullptr</returns>
+inline const ShaderArchiveDependency* ShaderArchive::GetDependencies(const ShaderArchiveEntry* entry)
+{
+	if (!IsOpen() || (unsigned long long)entry->dependencyIndex + entry->dependencyCount > mHeader->dependencyCount)
+		return nullptr;
+
+	return mDependencies + entry->dependencyIndex;
+}
+
+/// <summary>
+/// Get string from string table
+/// </summary>
+/// <param name="offset">Offset in string table</param>
+/// <returns>String or nullptr</returns>
+inline const char* ShaderArchive::GetString(unsigned int offset)
+{
+	if (!IsOpen() || offset >= mHeader->stringsSize)
+		return nullptr;
+
+	return mStrings + offset;
+}
+
+constexpr unsigned int ShaderServiceMagic = 0x53535248; // "HRSS"
+
+// Messages bigger than it is treated as broken stream
+constexpr unsigned int ShaderServiceMaxMessageSize = 64 * 1024 * 1024;
+
+/// <summary>
+/// Constructor
+/// </summary>
+inline ShaderServiceMessage::ShaderServiceMessage()
+{
+	mReadOffset = 0;
+}
+
+/// <summary>
+/// Write unsigned int
+/// </summary>
+inline void ShaderServiceMessage::PutUInt(unsigned int value)
+{
+	auto bytes = (const unsigned char*)&value;
+	mData.insert(mData.end(), bytes, bytes + sizeof(value));
+}
+
+/// <summary>
+/// Write unsigned long long
+/// </summary>
+inline void ShaderServiceMessage::PutUInt64(unsigned long long value)
+{
+	auto bytes = (const unsigned char*)&value;
+	mData.insert(mData.end(), bytes, bytes + sizeof(value));
+}
+
+/// <summary>
+/// Write bytes with size
+/// </summary>
+inline void ShaderServiceMessage::PutBytes(const void* data, size_t size)
+{
+	auto length = (unsigned int)size;
+	auto lengthBytes = (const unsigned char*)&length;
+	mData.insert(mData.end(), lengthBytes, lengthBytes + sizeof(length));
+
+	auto bytes = (const unsigned char*)data;
+	mData.insert(mData.end(), bytes, bytes + size);
+}
+
+/// <summary>
+/// Write string
+/// </summary>
+inline void ShaderServiceMessage::PutString(const char* value)
+{
+	PutBytes(value, value ? strlen(value) : 0);
+}
+
+/// <summary>
+/// Read unsigned int
+/// </summary>
+inline bool ShaderServiceMessage::GetUInt(unsigned int& value)
+{
+	if (mReadOffset + sizeof(value) > mData.size())
+		return false;
+
+	memcpy(&value, mData.data() + mReadOffset, sizeof(value));
+	mReadOffset += sizeof(value);
+	return true;
+}
+
+/// <summary>
+/// Read unsigned long long
+/// </summary>
+inline bool ShaderServiceMessage::GetUInt64(unsigned long long& value)
+{
+	if (mReadOffset + sizeof(value) > mData.size())
+		return false;
+
+	memcpy(&value, mData.data() + mReadOffset, sizeof(value));
+	mReadOffset += sizeof(value);
+	return true;
+}
+
+/// <summary>
+/// Read bytes with size
+/// </summary>
+inline bool ShaderServiceMessage::GetBytes(std::vector<unsigned char>& data)
+{
+	unsigned int length = 0;
+	if (!GetUInt(length) || mReadOffset + length > mData.size())
+		return false;
+
+	data.assign(mData.begin() + mReadOffset, mData.begin() + mReadOffset + length);
+	mReadOffset += length;
+	return true;
+}
+
+/// <summary>
+/// Read string
+/// </summary>
+inline bool ShaderServiceMessage::GetString(std::string& value)
+{
+	unsigned int length = 0;
+	if (!GetUInt(length) || mReadOffset + length > mData.size())
+		return false;
+
+	value.assign((const char*)mData.data() + mReadOffset, length);
+	mReadOffset += length;
+	return true;
+}
+
+/// <summary>
+/// Header and values as one packet
+/// </summary>
+/// <param name="type">Message type</param>
+/// <returns>Packet</returns>
+inline std::vector<unsigned char> ShaderServiceMessage::Pack(ShaderServiceMessageType type)
+{
+	ShaderServiceMessageHeader header = {};
+	header.magic = ShaderServiceMagic;
+	header.type = (unsigned int)type;
+	header.size = (unsigned int)mData.size();
+
+	std::vector<unsigned char> packet(sizeof(header) + mData.size());
+	memcpy(packet.data(), &header, sizeof(header));
+	if (!mData.empty())
+		memcpy(packet.data() + sizeof(header), mData.data(), mData.size());
+
+	return packet;
+}
+
+/// <summary>
+/// Send message in pipe
+/// </summary>
+/// <param name="pipe">Pipe</param>
+/// <param name="type">Message type</param>
+/// <returns>true if message is written</returns>
+inline bool ShaderServiceMessage::Send(HANDLE pipe, ShaderServiceMessageType type)
+{
+	// One write, so messages from different threads is not mixed
+	auto packet = Pack(type);
+
+	DWORD bytesWritten = 0;
+	return ::WriteFile(pipe, packet.data(), (DWORD)packet.size(), &bytesWritten, NULL) && bytesWritten == packet.size();
+}
+
+/// <summary>
+/// Append bytes from pipe
+/// </summary>
+inline void ShaderServiceReceiver::Append(const void* data, size_t size)
+{
+	auto bytes = (const unsigned char*)data;
+	mBuffer.insert(mBuffer.end(), bytes, bytes + size);
+}
+
+/// <summary>
+/// Take next complete message
+/// </summary>
+/// <param name="type">out message type</param>
+/// <param name="message">out message</param>
+/// <returns>false if there is no complete message</returns>
+inline bool ShaderServiceReceiver::Next(ShaderServiceMessageType& type, ShaderServiceMessage& message)
+{
+	if (bIsBroken || mBuffer.size() < sizeof(ShaderServiceMessageHeader))
+		return false;
+
+	ShaderServiceMessageHeader header = {};
+	memcpy(&header, mBuffer.data(), sizeof(header));
+	if (header.magic != ShaderServiceMagic || header.size > ShaderServiceMaxMessageSize)
+	{
+		bIsBroken = true;
+		return false;
+	}
+
+	if (mBuffer.size() < sizeof(header) + header.size)
+		return false;
+
+	type = (ShaderServiceMessageType)header.type;
+	message = {};
+	message.mData.assign(mBuffer.begin() + sizeof(header), mBuffer.begin() + sizeof(header) + header.size);
+	mBuffer.erase(mBuffer.begin(), mBuffer.begin() + sizeof(header) + header.size);
+	return true;
+}
+
+/// <summary>
+/// Is stream broken
+/// </summary>
+/// <returns></returns>
+inline bool ShaderServiceReceiver::IsBroken()
+{
+	return bIsBroken;
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+inline ShaderServiceWriter::ShaderServiceWriter()
+{
+	mPipe = INVALID_HANDLE_VALUE;
+	bIsBroken = false;
+	bIsStopping = false;
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+inline ShaderServiceWriter::~ShaderServiceWriter()
+{
+	Stop();
+}
+
+/// <summary>
+/// Start thread
+/// </summary>
+/// <param name="pipe">Pipe, opened with FILE_FLAG_OVERLAPPED</param>
+inline void ShaderServiceWriter::Start(HANDLE pipe)
+{
+	Stop();
+
+	mPipe = pipe;
+	mQueue.clear();
+	bIsBroken = false;
+	bIsStopping = false;
+	mThread = std::thread([this]() { WriterLoop(); });
+}
+
+/// <summary>
+/// Stop thread, pending write is cancelled
+/// </summary>
+inline void ShaderServiceWriter::Stop()
+{
+	if (!mThread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		bIsStopping = true;
+		mQueue.clear();
+	}
+	mChanged.notify_one();
+	CancelIoEx(mPipe, NULL);
+	mThread.join();
+}
+
+/// <summary>
+/// Add packet in queue
+/// </summary>
+/// <param name="packet">Packed message</param>
+/// <returns>false if pipe is broken or writer is not started</returns>
+inline bool ShaderServiceWriter::Queue(std::vector<unsigned char> packet)
+{
+	if (bIsBroken)
+		return false;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (!mThread.joinable() || bIsStopping)
+			return false;
+		mQueue.push_back(std::move(packet));
+	}
+	mChanged.notify_one();
+	return true;
+}
+
+/// <summary>
+/// Is write failed
+/// </summary>
+/// <returns></returns>
+inline bool ShaderServiceWriter::IsBroken()
+{
+	return bIsBroken;
+}
+
+/// <summary>
+/// Write queued packets one by one
+/// </summary>
+inline void ShaderServiceWriter::WriterLoop()
+{
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+	while (true)
+	{
+		std::vector<unsigned char> packet;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mChanged.wait(lock, [this]() { return bIsStopping || !mQueue.empty(); });
+			if (bIsStopping)
+				break;
+
+			packet.swap(mQueue.front());
+			mQueue.pop_front();
+		}
+
+		ResetEvent(overlapped.hEvent);
+		DWORD bytes = 0;
+		BOOL isDone = ::WriteFile(mPipe, packet.data(), (DWORD)packet.size(), NULL, &overlapped);
+		if ((!isDone && GetLastError() != ERROR_IO_PENDING) || !GetOverlappedResult(mPipe, &overlapped, &bytes, TRUE) || bytes != packet.size())
+		{
+			bIsBroken = true;
+			break;
+		}
+	}
+
+	CloseHandle(overlapped.hEvent);
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+inline ShaderDiagnostics::ShaderDiagnostics()
+{
+	// Slots is allocated once, slot of position is free when its sequence is equal to position
+	mCells.reset(new Cell[QueueCapacity]);
+	for (size_t i = 0; i < QueueCapacity; i++)
+		mCells[i].sequence.store(i, std::memory_order_relaxed);
+	mEnqueuePosition = 0;
+	mDequeuePosition = 0;
+
+	mReportedCount = 0;
+	mProcessedCount = 0;
+	mDroppedCount = 0;
+	mPass = 0;
+	mDeduplicationWindow = 5000;
+	mRateLimitRecords = 20;
+	mRateLimitWindow = 1000;
+	bIsStopping = false;
+
+	mSinks.push_back(MakeConsoleSink());
+	mWorker = std::thread([this]() { WorkerLoop(); });
+}
+
+/// <summary>
+/// Destructor, all records in queue is written
+/// </summary>
+inline ShaderDiagnostics::~ShaderDiagnostics()
+{
+	bIsStopping = true;
+	mWake.notify_one();
+	if (mWorker.joinable())
+		mWorker.join();
+}
+
+/// <summary>
+/// Take free slot, fill it and publish it
+/// Producers race only for position, record is dropped if consumer is behind by whole ring
+/// </summary>
+/// <param name="fill">Called with slot, must set every field of record</param>
+template <typename Fill>
+inline void ShaderDiagnostics::Push(const Fill& fill)
+{
+	Cell* cell = nullptr;
+	auto position = mEnqueuePosition.load(std::memory_order_relaxed);
+	while (true)
+	{
+		cell = &mCells[position & (QueueCapacity - 1)];
+		auto sequence = cell->sequence.load(std::memory_order_acquire);
+		auto difference = (long long)sequence - (long long)position;
+		if (difference == 0)
+		{
+			if (mEnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (difference < 0)
+		{
+			// Full, render thread is never blocked by slow sink
+			mDroppedCount.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else
+		{
+			position = mEnqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	fill(cell->diagnostic);
+	cell->diagnostic.repeatCount = 0;
+	cell->diagnostic.pass = mPass.load(std::memory_order_relaxed);
+
+	mReportedCount.fetch_add(1, std::memory_order_relaxed);
+	cell->sequence.store(position + 1, std::memory_order_release);
+
+	mWake.notify_one();
+}
+
+/// <summary>
+/// Add record in queue, lock-free
+/// </summary>
+/// <param name="diagnostic">Record, it is copied in slot</param>
+inline void ShaderDiagnostics::Report(const ShaderDiagnostic& diagnostic)
+{
+	Push([&diagnostic](ShaderDiagnostic& slot) {
+		slot.severity = diagnostic.severity;
+		slot.localName.assign(diagnostic.localName);
+		slot.file.assign(diagnostic.file);
+		slot.line = diagnostic.line;
+		slot.column = diagnostic.column;
+		slot.code.assign(diagnostic.code);
+		slot.message.assign(diagnostic.message);
+	});
+}
+
+/// <summary>
+/// Add simple record in queue
+/// </summary>
+/// <param name="severity">Severity</param>
+/// <param name="localName">Bundle, can be nullptr</param>
+/// <param name="file">File, can be nullptr</param>
+/// <param name="message">Message</param>
+inline void ShaderDiagnostics::Report(ShaderDiagnosticSeverity severity, const char* localName, const char* file, const char* message)
+{
+	// Strings is assigned in slot directly, no temporary record
+	Push([&](ShaderDiagnostic& slot) {
+		slot.severity = severity;
+		slot.localName.assign(localName ? localName : "");
+		slot.file.assign(file ? file : "");
+		slot.line = 0;
+		slot.column = 0;
+		slot.code.clear();
+		slot.message.assign(message ? message : "");
+	});
+}
+
+/// <summary>
+/// Parse compiler output and add records in queue
+/// Format: file(line,column[-column]): error|warning X0000: message
+/// </summary>
+/// <param name="localName">Bundle, can be nullptr</param>
+/// <param name="output">Compiler output</param>
+inline void ShaderDiagnostics::ReportCompilerOutput(const char* localName, const char* output)
+{
+	if (!output)
+		return;
+
+	std::string text = output;
+	size_t lineStart = 0;
+	while (lineStart < text.size())
+	{
+		auto lineEnd = text.find('\n', lineStart);
+		if (lineEnd == std::string::npos)
+			lineEnd = text.size();
+
+		std::string line = text.substr(lineStart, lineEnd - lineStart);
+		lineStart = lineEnd + 1;
+
+		while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+			line.pop_back();
+		if (line.empty())
+			continue;
+
+		ShaderDiagnostic diagnostic = {};
+		diagnostic.severity = ShaderDiagnosticSeverity::Error;
+		diagnostic.localName = localName ? localName : "";
+		diagnostic.message = line;
+
+		// Position
+		auto positionEnd = line.find("): ");
+		auto positionStart = positionEnd == std::string::npos ? std::string::npos : line.rfind('(', positionEnd);
+		if (positionStart != std::string::npos)
+		{
+			diagnostic.file = line.substr(0, positionStart);
+			sscanf_s(line.c_str() + positionStart + 1, "%d,%d", &diagnostic.line, &diagnostic.column);
+
+			// Severity and code
+			std::string rest = line.substr(positionEnd + 3);
+			auto codeEnd = rest.find(": ");
+			if (codeEnd != std::string::npos)
+			{
+				std::string kind = rest.substr(0, codeEnd);
+				auto space = kind.find(' ');
+				std::string severity = kind.substr(0, space);
+				if (severity == "warning")
+					diagnostic.severity = ShaderDiagnosticSeverity::Warning;
+				else if (severity != "error")
+					diagnostic.severity = ShaderDiagnosticSeverity::Info;
+
+				if (space != std::string::npos)
+					diagnostic.code = kind.substr(space + 1);
+				rest = rest.substr(codeEnd + 2);
+			}
+			diagnostic.message = rest;
+		}
+		else if (line.find("warning") != std::string::npos)
+		{
+			diagnostic.severity = ShaderDiagnosticSeverity::Warning;
+		}
+
+		Report(diagnostic);
+	}
+}
+
+/// <summary>
+/// Add sink
+/// </summary>
+/// <param name="sink">Sink, called from background thread</param>
+inline void ShaderDiagnostics::AddSink(Sink sink)
+{
+	std::lock_guard<std::mutex> lock(mSinksMutex);
+	mSinks.push_back(sink);
+}
+
+/// <summary>
+/// Remove all sinks
+/// </summary>
+inline void ShaderDiagnostics::ClearSinks()
+{
+	std::lock_guard<std::mutex> lock(mSinksMutex);
+	mSinks.clear();
+}
+
+/// <summary>
+/// Set deduplication window
+/// </summary>
+/// <param name="milliseconds">Window, 0 - disable deduplication</param>
+inline void ShaderDiagnostics::SetDeduplicationWindow(unsigned int milliseconds)
+{
+	mDeduplicationWindow = milliseconds;
+}
+
+/// <summary>
+/// Start new compile pass
+/// Error which is still in file after next save is written again
+/// </summary>
+inline void ShaderDiagnostics::BeginPass()
+{
+	mPass.fetch_add(1, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Set rate limit of bundle
+/// </summary>
+/// <param name="maxRecords">Records in window, 0 - no limit</param>
+/// <param name="milliseconds">Window</param>
+inline void ShaderDiagnostics::SetRateLimit(unsigned int maxRecords, unsigned int milliseconds)
+{
+	mRateLimitRecords = maxRecords;
+	mRateLimitWindow = milliseconds;
+}
+
+/// <summary>
+/// Wait until all records is written
+/// </summary>
+inline void ShaderDiagnostics::Flush()
+{
+	auto reported = mReportedCount.load();
+	while (mProcessedCount.load() < reported && mWorker.joinable())
+	{
+		mWake.notify_one();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	// Files is kept open by sinks
+	std::lock_guard<std::mutex> lock(mSinksMutex);
+	for (auto& sink : mSinks)
+	{
+		auto fileSink = sink.target<FileSink>();
+		if (fileSink && fileSink->file)
+			fflush(fileSink->file.get());
+	}
+}
+
+/// <summary>
+/// Sink which prints records in console
+/// </summary>
+/// <returns>Sink</returns>
+inline ShaderDiagnostics::Sink ShaderDiagnostics::MakeConsoleSink()
+{
+	return [](const ShaderDiagnostic& diagnostic) {
+		const char* severity = diagnostic.severity == ShaderDiagnosticSeverity::Error ? "error" :
+			diagnostic.severity == ShaderDiagnosticSeverity::Warning ? "warning" : "info";
+
+		if (!diagnostic.file.empty() && diagnostic.line > 0)
+			printf("%s(%d,%d): %s %s: %s", diagnostic.file.c_str(), diagnostic.line, diagnostic.column, severity, diagnostic.code.c_str(), diagnostic.message.c_str());
+		else if (!diagnostic.file.empty())
+			printf("<%s> %s: %s", diagnostic.file.c_str(), severity, diagnostic.message.c_str());
+		else
+			printf("%s: %s", severity, diagnostic.message.c_str());
+
+		if (!diagnostic.localName.empty())
+			printf(" [%s]", diagnostic.localName.c_str());
+		if (diagnostic.repeatCount)
+			printf(" (repeated %u times)", diagnostic.repeatCount);
+		printf("\n");
+	};
+}
+
+/// <summary>
+/// Sink which appends records in file
+/// </summary>
+/// <param name="path">Path to log file</param>
+/// <returns>Sink</returns>
+inline ShaderDiagnostics::Sink ShaderDiagnostics::MakeFileSink(const char* path)
+{
+	// File is opened once and closed with last copy of sink
+	FILE* f = nullptr;
+	fopen_s(&f, path, "a");
+
+	FileSink sink;
+	if (f)
+		sink.file.reset(f, fclose);
+	return sink;
+}
+
+/// <summary>
+/// Append record in file
+/// </summary>
+/// <param name="diagnostic">Record</param>
+inline void ShaderDiagnostics::FileSink::operator()(const ShaderDiagnostic& diagnostic) const
+{
+	if (!file)
+		return;
+
+	const char* severity = diagnostic.severity == ShaderDiagnosticSeverity::Error ? "error" :
+		diagnostic.severity == ShaderDiagnosticSeverity::Warning ? "warning" : "info";
+	fprintf(file.get(), "%s(%d,%d): %s %s: %s [%s] (repeated %u times)\n", diagnostic.file.c_str(), diagnostic.line, diagnostic.column,
+		severity, diagnostic.code.c_str(), diagnostic.message.c_str(), diagnostic.localName.c_str(), diagnostic.repeatCount);
+}
+
+/// <summary>
+/// Background thread loop
+/// </summary>
+inline void ShaderDiagnostics::WorkerLoop()
+{
+	while (true)
+	{
+		// Take all records, slot is processed in place and given back to producers
+		while (true)
+		{
+			auto& cell = mCells[mDequeuePosition & (QueueCapacity - 1)];
+			if (cell.sequence.load(std::memory_order_acquire) != mDequeuePosition + 1)
+				break;
+
+			Process(cell.diagnostic);
+			cell.sequence.store(mDequeuePosition + QueueCapacity, std::memory_order_release);
+			mDequeuePosition++;
+			mProcessedCount.fetch_add(1, std::memory_order_release);
+		}
+
+		// Records which is not fit in ring
+		auto dropped = mDroppedCount.exchange(0, std::memory_order_relaxed);
+		if (dropped)
+		{
+			ShaderDiagnostic summary = {};
+			summary.severity = ShaderDiagnosticSeverity::Warning;
+			summary.message = std::to_string(dropped) + " diagnostics is dropped, queue is full";
+			Emit(summary);
+		}
+
+		// Bundle can go quiet after it is limited, its summary is not waiting for next record
+		FlushRateSummaries(std::chrono::steady_clock::now(), bIsStopping);
+
+		if (bIsStopping)
+			break;
+
+		// Producers don't lock, so wakeup can be missed - timeout is covered it
+		std::unique_lock<std::mutex> lock(mWakeMutex);
+		mWake.wait_for(lock, std::chrono::milliseconds(50));
+	}
+}
+
+/// <summary>
+/// Dedupe, rate-limit and write record
+/// </summary>
+/// <param name="diagnostic">Record</param>
+inline void ShaderDiagnostics::Process(ShaderDiagnostic& diagnostic)
+{
+	auto now = std::chrono::steady_clock::now();
+
+	// Same error from header is reported by every shader which includes it
+	auto deduplicationWindow = std::chrono::milliseconds(mDeduplicationWindow.load());
+	if (deduplicationWindow.count())
+	{
+		auto key = HashBytes(&diagnostic.pass, sizeof(diagnostic.pass));
+		key = HashBytes(diagnostic.file.data(), diagnostic.file.size(), key);
+		key = HashBytes(&diagnostic.line, sizeof(diagnostic.line), key);
+		key = HashBytes(&diagnostic.column, sizeof(diagnostic.column), key);
+		key = HashBytes(&diagnostic.severity, sizeof(diagnostic.severity), key);
+		key = HashBytes(diagnostic.message.data(), diagnostic.message.size(), key);
+
+		auto seen = mSeenRecords.find(key);
+		if (seen != mSeenRecords.end() && now - seen->second.time < deduplicationWindow)
+		{
+			seen->second.suppressed++;
+			return;
+		}
+
+		// Window is passed, tell how many times it was repeated
+		if (seen != mSeenRecords.end())
+			diagnostic.repeatCount = seen->second.suppressed;
+		mSeenRecords[key] = { now, 0 };
+
+		// Forget old records
+		for (auto record = mSeenRecords.begin(); record != mSeenRecords.end();)
+		{
+			auto age = now - record->second.time;
+			if ((age >= deduplicationWindow && !record->second.suppressed) || age >= deduplicationWindow * 10)
+				record = mSeenRecords.erase(record);
+			else
+				record++;
+		}
+	}
+
+	// Rate limit of bundle
+	auto rateLimitRecords = mRateLimitRecords.load();
+	if (rateLimitRecords && !diagnostic.localName.empty())
+	{
+		FlushRateSummaries(now, false);
+
+		auto& rate = mBundleRates[diagnostic.localName];
+		if (now - rate.windowStart >= std::chrono::milliseconds(mRateLimitWindow.load()))
+			rate = { now, 0, 0 };
+
+		if (rate.count >= rateLimitRecords)
+		{
+			rate.dropped++;
+			return;
+		}
+		rate.count++;
+	}
+
+	Emit(diagnostic);
+}
+
+/// <summary>
+/// Write summaries of rate limited bundles
+/// Called by background thread for every batch of records and on every wakeup, so last count is never lost
+/// </summary>
+/// <param name="now">Current time</param>
+/// <param name="isAll">Write all summaries, window is not checked (stopping)</param>
+inline void ShaderDiagnostics::FlushRateSummaries(std::chrono::steady_clock::time_point now, bool isAll)
+{
+	auto window = std::chrono::milliseconds(mRateLimitWindow.load());
+	for (auto rate = mBundleRates.begin(); rate != mBundleRates.end();)
+	{
+		bool isPassed = isAll || now - rate->second.windowStart >= window;
+		if (!isPassed)
+		{
+			rate++;
+			continue;
+		}
+
+		if (rate->second.dropped)
+		{
+			ShaderDiagnostic summary = {};
+			summary.severity = ShaderDiagnosticSeverity::Info;
+			summary.localName = rate->first;
+			summary.message = std::to_string(rate->second.dropped) + " diagnostics is suppressed by rate limit";
+			Emit(summary);
+		}
+		rate = mBundleRates.erase(rate);
+	}
+}
+
+/// <summary>
+/// Write record in all sinks
+/// </summary>
+/// <param name="diagnostic">Record</param>
+inline void ShaderDiagnostics::Emit(const ShaderDiagnostic& diagnostic)
+{
+	std::lock_guard<std::mutex> lock(mSinksMutex);
+	for (auto& sink : mSinks)
+		sink(diagnostic);
+}
+
+/// <summary>
+/// Stored copy of string
+/// </summary>
+/// <param name="string">String to intern</param>
+/// <returns>Pointer which is same for equal strings, nullptr for nullptr</returns>
+inline const char* ShaderStringArena::Intern(const char* string)
+{
+	if (!string)
+		return nullptr;
+
+	auto found = mStrings.find(string);
+	if (found != mStrings.end())
+		return found->second;
+
+	auto length = strlen(string) + 1;
+	char* stored = nullptr;
+	if (length > BlockSize / 4)
+	{
+		// Long string gets own block, current block is still filled
+		mBlocks.emplace(mBlocks.begin(), new char[length]);
+		stored = mBlocks.front().get();
+	}
+	else
+	{
+		if (mBlocks.empty() || mBlockUsed + length > BlockSize)
+		{
+			mBlocks.emplace_back(new char[BlockSize]);
+			mBlockUsed = 0;
+		}
+		stored = mBlocks.back().get() + mBlockUsed;
+		mBlockUsed += length;
+	}
+
+	memcpy(stored, string, length);
+	mSize += length;
+	mStrings.emplace(std::string_view(stored, length - 1), stored);
+	return stored;
+}
+
+/// <summary>
+/// Stored copy of string, string is not added
+/// </summary>
+/// <param name="string">String to find</param>
+/// <returns>nullptr if string is not interned</returns>
+inline const char* ShaderStringArena::Find(const char* string) const
+{
+	if (!string)
+		return nullptr;
+
+	auto found = mStrings.find(string);
+	return found != mStrings.end() ? found->second : nullptr;
+}
+
+/// <summary>
+/// Free all strings, stored pointers is invalid after call
+/// </summary>
+inline void ShaderStringArena::Clear()
+{
+	mStrings.clear();
+	mBlocks.clear();
+	mBlockUsed = 0;
+	mSize = 0;
+}
+
+/// <summary>
+/// Full lowercase path with backslashes
+/// </summary>
+/// <param name="path">Path</param>
+/// <returns>Normalized path</returns>
+inline std::string NormalizeShaderPath(const char* path)
+{
+	char fullPath[MAX_PATH] = {};
+	auto length = GetFullPathNameA(path, MAX_PATH, fullPath, nullptr);
+
+	std::string result = length > 0 && length < MAX_PATH ? fullPath : path;
+	for (auto& c : result)
+		c = c == '/' ? '\\' : (char)tolower((unsigned char)c);
+
+	return result;
+}
+
+inline ShaderDirectoryWatcher::ShaderDirectoryWatcher()
+{
+}
+
+inline ShaderDirectoryWatcher::~ShaderDirectoryWatcher()
+{
+	for (auto& directory : mDirectories)
+		Disarm(*directory.second);
+}
+
+/// <summary>
+/// Watch directory of file
+/// </summary>
+/// <param name="filePath">Path to file</param>
+/// <returns>false if directory can't be watched, write times is polled anyway</returns>
+inline bool ShaderDirectoryWatcher::WatchFileDirectory(const char* filePath)
+{
+	auto path = NormalizeShaderPath(filePath);
+	auto slash = path.find_last_of('\\');
+	if (slash == std::string::npos)
+		return false;
+	path.resize(slash);
+
+	auto& directory = mDirectories[path];
+	if (!directory)
+	{
+		directory.reset(new WatchedDirectory());
+		directory->path = path;
+		directory->handle = INVALID_HANDLE_VALUE;
+		directory->overlapped = {};
+		directory->buffer.resize(16 * 1024);
+		directory->isArmed = false;
+	}
+
+	return directory->isArmed || Arm(*directory);
+}
+
+/// <summary>
+/// Open directory and start reading changes
+/// </summary>
+/// <param name="directory">Directory</param>
+/// <returns></returns>
+inline bool ShaderDirectoryWatcher::Arm(WatchedDirectory& directory)
+{
+	if (directory.handle == INVALID_HANDLE_VALUE)
+	{
+		directory.handle = CreateFileA(directory.path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+		if (directory.handle == INVALID_HANDLE_VALUE)
+			return false;
+
+		directory.overlapped = {};
+		directory.overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+	}
+
+	ResetEvent(directory.overlapped.hEvent);
+	directory.isArmed = ReadDirectoryChangesW(directory.handle, directory.buffer.data(), (DWORD)(directory.buffer.size() * sizeof(DWORD)), FALSE,
+		FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_CREATION,
+		nullptr, &directory.overlapped, nullptr) != FALSE;
+
+	if (!directory.isArmed)
+		Disarm(directory);
+
+	return directory.isArmed;
+}
+
+/// <summary>
+/// Stop reading and close directory
+/// </summary>
+/// <param name="directory">Directory</param>
+inline void ShaderDirectoryWatcher::Disarm(WatchedDirectory& directory)
+{
+	if (directory.handle == INVALID_HANDLE_VALUE)
+		return;
+
+	// Buffer is used by system until read is finished
+	if (directory.isArmed)
+	{
+		DWORD bytes = 0;
+		CancelIoEx(directory.handle, &directory.overlapped);
+		GetOverlappedResult(directory.handle, &directory.overlapped, &bytes, TRUE);
+	}
+
+	CloseHandle(directory.overlapped.hEvent);
+	CloseHandle(directory.handle);
+	directory.handle = INVALID_HANDLE_VALUE;
+	directory.isArmed = false;
+}
+
+/// <summary>
+/// Take paths changed after last call
+/// </summary>
+/// <param name="changedPaths">out normalized paths</param>
+/// <returns>false if events is lost, then all files must be checked</returns>
+inline bool ShaderDirectoryWatcher::Poll(std::vector<std::string>& changedPaths)
+{
+	bool isComplete = true;
+	for (auto& watched : mDirectories)
 	{
-		WIN32_FIND_DATAA findData;
-		auto handle = FindFirstFileA(info.hlslPath, &findData);
-		if (handle == INVALID_HANDLE_VALUE)
+		auto& directory = *watched.second;
+
+		// Directory is removed or created again
+		if (!directory.isArmed)
+		{
+			if (Arm(directory))
+				isComplete = false;
+			continue;
+		}
+
+		DWORD bytes = 0;
+		if (!GetOverlappedResult(directory.handle, &directory.overlapped, &bytes, FALSE))
 		{
-			// Moved, Changed, Renamed, Deleted?
+			if (GetLastError() == ERROR_IO_INCOMPLETE)
+				continue;
+
+			Disarm(directory);
+			isComplete = false;
 			continue;
 		}
-		FindClose(handle);
 
-		auto time = FileTimeToUInt64(findData.ftLastWriteTime);
-		if (mTimeChanged[info.localName] != time)
-		{
-			CompileFile(info);
+		// Too many changes for buffer
+		if (bytes == 0)
+			isComplete = false;
+
+		auto data = (const unsigned char*)directory.buffer.data();
+		for (DWORD offset = 0; bytes > 0 && offset < bytes;)
+		{
+			auto notify = (const FILE_NOTIFY_INFORMATION*)(data + offset);
+
+			char name[MAX_PATH] = {};
+			auto length = WideCharToMultiByte(CP_ACP, 0, notify->FileName, (int)(notify->FileNameLength / sizeof(WCHAR)), name, MAX_PATH - 1, nullptr, nullptr);
+			if (length > 0)
+			{
+				std::string path = directory.path + "\\" + std::string(name, length);
+				for (auto& c : path)
+					c = (char)tolower((unsigned char)c);
+				changedPaths.push_back(path);
+			}
+
+			if (!notify->NextEntryOffset)
+				break;
+			offset += notify->NextEntryOffset;
+		}
+
+		if (!Arm(directory))
+			isComplete = false;
+	}
+
+	return isComplete;
+}
 
-			// Update last time 
-			mTimeChanged[info.localName] = time;
-		}
+/// <summary>
+/// Constructor
+/// </summary>
+inline ShaderPollingWatcher::ShaderPollingWatcher()
+{
+	mStatistics = {};
+	mHotInterval = std::chrono::milliseconds(100);
+	mColdInterval = std::chrono::milliseconds(2000);
+	mHotTime = std::chrono::milliseconds(10000);
+	mCallBudget = 256;
+	bIsStopping = false;
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+inline ShaderPollingWatcher::~ShaderPollingWatcher()
+{
+	Stop();
+}
+
+/// <summary>
+/// Start thread
+/// </summary>
+/// <param name="hotInterval">Interval of directory with file changed in last 10 seconds, ms</param>
+/// <param name="coldInterval">Max interval of directory without changes, interval is doubled after every listing without changes, ms</param>
+/// <param name="callBudget">Max count of file system calls per cycle, at least one directory is listed per cycle</param>
+inline void ShaderPollingWatcher::Start(unsigned int hotInterval, unsigned int coldInterval, unsigned int callBudget)
+{
+	Stop();
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mHotInterval = std::chrono::milliseconds(std::max(hotInterval, 1u));
+		mColdInterval = std::chrono::milliseconds(std::max(coldInterval, hotInterval));
+		mCallBudget = std::max(callBudget, 1u);
+		bIsStopping = false;
 	}
 
-	// if callback is set
-	// Call it
-	if (mCustomCallbackWhenShadersIsCompiled && IsCompiled())
+	mThread = std::thread([this]() { ThreadLoop(); });
+}
+
+/// <summary>
+/// Stop thread, listed times is kept
+/// </summary>
+inline void ShaderPollingWatcher::Stop()
+{
+	if (!mThread.joinable())
+		return;
+
 	{
-		mCustomCallbackWhenShadersIsCompiled();
+		std::lock_guard<std::mutex> lock(mMutex);
+		bIsStopping = true;
 	}
+	mWake.notify_all();
+	mThread.join();
 }
 
 /// <summary>
-/// Read file 
+/// Is thread running
 /// </summary>
-/// <param name="filename">Path to file</param>
-/// <param name="buffer">out buffer</param>
 /// <returns></returns>
-inline bool ReadFile(const char* filename, std::vector<unsigned char>& buffer)
+inline bool ShaderPollingWatcher::IsRunning()
 {
-	// sometimes text editors may not have time to update the file,
-	// in which case the buffer will be empty. 
-	// Try to read it again.
-	int maxAttempts = 5;
-	int attempts = 0;
-	for (int i = 0; i < maxAttempts; i++)
-	{
-		// Open file
-		HANDLE hFile = CreateFileA(
-			filename,
-			GENERIC_READ,
-			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, // set all mode, because all most code editors opened file with all mode.
-			NULL,
-			OPEN_EXISTING,
-			FILE_ATTRIBUTE_NORMAL,
-			NULL
-		);
+	return mThread.joinable();
+}
 
-		if (hFile == INVALID_HANDLE_VALUE) {
-			return false;
-		}
+/// <summary>
+/// Normalized path, normalization is cached
+/// </summary>
+/// <param name="filePath">Path to file</param>
+/// <returns>Normalized path</returns>
+inline const std::string& ShaderPollingWatcher::GetNormalizedPath(const char* filePath)
+{
+	auto normalized = mNormalizedPaths.find(filePath);
+	if (normalized == mNormalizedPaths.end())
+		normalized = mNormalizedPaths.emplace(filePath, NormalizeShaderPath(filePath)).first;
 
-		LARGE_INTEGER fileSize;
-		if (!GetFileSizeEx(hFile, &fileSize)) {
-			CloseHandle(hFile);
-			return false;
-		}
+	return normalized->second;
+}
 
-		// if size = 0;
-		// the file did not have time to update
-		if (fileSize.QuadPart == 0)
+/// <summary>
+/// Directory and name of normalized path
+/// </summary>
+/// <returns>false if path has no directory</returns>
+inline bool ShaderPollingWatcher::SplitPath(const std::string& path, std::string& directory, std::string& name)
+{
+	auto slash = path.find_last_of('\\');
+	if (slash == std::string::npos)
+		return false;
+
+	directory = path.substr(0, slash);
+	name = path.substr(slash + 1);
+	return true;
+}
+
+/// <summary>
+/// Poll file
+/// </summary>
+/// <param name="filePath">Path to file</param>
+inline void ShaderPollingWatcher::WatchFile(const char* filePath)
+{
+	bool isAdded = false;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		std::string directoryPath, name;
+		if (!SplitPath(GetNormalizedPath(filePath), directoryPath, name))
+			return;
+
+		auto directory = mDirectories.find(directoryPath);
+		if (directory == mDirectories.end())
 		{
-			attempts++;
-			continue;
+			directory = mDirectories.emplace(directoryPath, PolledDirectory()).first;
+			directory->second.interval = mHotInterval;
+			directory->second.isHot = false;
 		}
 
-		buffer.resize(fileSize.QuadPart);
-		DWORD bytesRead = 0;
-		if (!ReadFile(hFile, buffer.data(), (DWORD)fileSize.QuadPart, &bytesRead, NULL)) {
-			CloseHandle(hFile);
-			return false;
-		}
+		if (directory->second.files.count(name))
+			return;
 
-		CloseHandle(hFile);
+		directory->second.files[name] = {};
 
-		return true;
+		// List it in next cycle
+		directory->second.nextTime = {};
+		isAdded = true;
 	}
 
-	printf("File <%s> It can't be read, check the editor where you're editing the file, there might be a problem with it. Attempt[%i]\"", filename, attempts);
-
-	return false;
+	if (isAdded)
+		mWake.notify_all();
 }
 
 /// <summary>
-/// Compile file
+/// Last listed write time of file, file is watched if it is not watched yet
 /// </summary>
-/// <param name="filePath">.hlsl path</param>
-/// <param name="info">Shader information</param>
-/// <returns>bool is compiled otherwise false</returns>
-inline bool HotReloadableShaders::CompileFile(ShaderInformation& info)
+/// <param name="filePath">Path to file</param>
+/// <param name="time">out write time, 0 if file is not exist</param>
+/// <param name="isExist">out is file found in last listing</param>
+/// <returns>false if file is not listed yet</returns>
+inline bool ShaderPollingWatcher::GetWriteTime(const char* filePath, unsigned long long& time, bool& isExist)
 {
-	std::vector<unsigned char> fileBuffer;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
 
-	bool isDone = ReadFile(info.hlslPath, fileBuffer);
-	if (!isDone)
-		return false;
+		std::string directoryPath, name;
+		if (!SplitPath(GetNormalizedPath(filePath), directoryPath, name))
+			return false;
 
-	// Compile shader
-	ID3DBlob* shader = nullptr;
-	ID3DBlob* error = nullptr;
-	auto hr = D3DCompile(fileBuffer.data(), fileBuffer.size(), nullptr, nullptr, nullptr, info.entryPoint, info.shaderVersion, 0, 0, &shader, &error);
-	if (FAILED(hr))
-	{
-		if (error)
+		auto directory = mDirectories.find(directoryPath);
+		if (directory != mDirectories.end())
 		{
-			printf("Failed compile <%s> error message:\n%s", info.hlslPath, (const char*)error->GetBufferPointer());
-			error->Release();
-			error = nullptr;
+			auto file = directory->second.files.find(name);
+			if (file != directory->second.files.end())
+			{
+				time = file->second.writeTime;
+				isExist = file->second.isExist;
+				return file->second.isListed;
+			}
 		}
-		return false;
 	}
 
-	// Create compiled shaders
-	if (info.localShaderType == HotReloadableShaderType::VertexShader)
-	{
-		auto isCreated = CreateVertexShader(info, shader);
-		if (!isCreated)
-			return false;
-	}
-	else if (info.localShaderType == HotReloadableShaderType::PixelShader)
-	{
-		auto isCreated = CreatePixelShader(info, shader);
-		if (!isCreated)
-			return false;
-	}
+	WatchFile(filePath);
+	return false;
+}
 
-	// Generate .cso from compiled shaders
-	if (info.bSaveToCSO)
+/// <summary>
+/// Take paths changed after last call
+/// </summary>
+/// <param name="changedPaths">out normalized paths are appended</param>
+inline void ShaderPollingWatcher::Poll(std::vector<std::string>& changedPaths)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	changedPaths.insert(changedPaths.end(), mChangedPaths.begin(), mChangedPaths.end());
+	mChangedPaths.clear();
+}
+
+/// <summary>
+/// Counters
+/// </summary>
+/// <returns></returns>
+inline ShaderPollingStatistics ShaderPollingWatcher::GetStatistics()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto statistics = mStatistics;
+	statistics.directoryCount = (unsigned int)mDirectories.size();
+	for (auto& directory : mDirectories)
+		statistics.hotDirectoryCount += directory.second.isHot ? 1 : 0;
+
+	return statistics;
+}
+
+/// <summary>
+/// List directory, one listing gives write times of all files in it
+/// </summary>
+/// <param name="directory">Normalized path to directory</param>
+/// <param name="times">out write time and is directory flag by lowercase name</param>
+/// <param name="calls">out count of file system calls is added</param>
+/// <returns>false if directory can't be read now (not if it is removed)</returns>
+inline bool ShaderPollingWatcher::ListDirectory(const std::string& directory, std::map<std::string, std::pair<unsigned long long, bool>>& times, unsigned long long& calls)
+{
+	WIN32_FIND_DATAA findData;
+	auto handle = FindFirstFileExA((directory + "\\*").c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+	calls++;
+	if (handle == INVALID_HANDLE_VALUE)
 	{
-		GenerateCSO(info, shader->GetBufferPointer(), (int)shader->GetBufferSize());
+		// Removed directory has no files, share which is not available keeps last times
+		auto error = GetLastError();
+		return error == ERROR_PATH_NOT_FOUND || error == ERROR_FILE_NOT_FOUND;
 	}
 
-	// Release buffers
-	fileBuffer.clear();
+	do
+	{
+		std::string name = findData.cFileName;
+		for (auto& c : name)
+			c = (char)tolower((unsigned char)c);
+		times[name] = { FileTimeToUInt64(findData.ftLastWriteTime), (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0 };
+		calls++;
+	} while (FindNextFileA(handle, &findData));
 
+	FindClose(handle);
+	calls++;
 	return true;
 }
 
 /// <summary>
-/// Create pixel shader
+/// Thread loop
+/// Every cycle due directories is listed, the most overdue first, until budget of file system calls is spent
 /// </summary>
-/// <param name="info">Shader information</param>
-/// <param name="shader">shader blob</param>
-/// <returns></returns>
-inline bool HotReloadableShaders::CreatePixelShader(ShaderInformation& info, ID3DBlob* shader)
+inline void ShaderPollingWatcher::ThreadLoop()
 {
-	auto sh = mCompiledShadersA.find(info.localName);
-	if (sh != mCompiledShadersA.end())
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true)
 	{
-		if (sh->second)
+		mWake.wait_for(lock, std::min(mHotInterval, std::chrono::milliseconds(50)), [this]() { return bIsStopping; });
+		if (bIsStopping)
+			return;
+
+		auto now = std::chrono::steady_clock::now();
+		mStatistics.cycles++;
+
+		// Due directories
+		std::vector<std::pair<std::chrono::steady_clock::time_point, std::string>> dueDirectories;
+		for (auto& directory : mDirectories)
+		{
+			if (directory.second.nextTime <= now)
+				dueDirectories.push_back({ directory.second.nextTime, directory.first });
+		}
+		std::sort(dueDirectories.begin(), dueDirectories.end());
+
+		unsigned long long calls = 0;
+		for (size_t i = 0; i < dueDirectories.size(); i++)
 		{
-			mCompiledShadersA[info.localName]->Release();
-			mCompiledShadersA[info.localName] = nullptr;
+			if (calls >= mCallBudget)
+			{
+				mStatistics.deferredListings += dueDirectories.size() - i;
+				break;
+			}
+
+			// File system is not touched under lock
+			auto& path = dueDirectories[i].second;
+			std::map<std::string, std::pair<unsigned long long, bool>> times;
+			lock.unlock();
+			bool isListed = ListDirectory(path, times, calls);
+			lock.lock();
+
+			mStatistics.listings++;
+			auto found = mDirectories.find(path);
+			if (found == mDirectories.end())
+				continue;
+
+			auto& directory = found->second;
+			now = std::chrono::steady_clock::now();
+			if (isListed)
+			{
+				for (auto& file : directory.files)
+				{
+					auto time = times.find(file.first);
+					bool isExist = time != times.end() && !time->second.second;
+					auto writeTime = isExist ? time->second.first : 0;
+
+					// First listing of file is not a change
+					if (file.second.isListed && (file.second.isExist != isExist || file.second.writeTime != writeTime))
+					{
+						file.second.changeTime = now;
+						mChangedPaths.push_back(path + "\\" + file.first);
+						mStatistics.changes++;
+					}
+
+					file.second.writeTime = writeTime;
+					file.second.isExist = isExist;
+					file.second.isListed = true;
+				}
+			}
+
+			// Hot directory is listed often, cold directory more and more rarely
+			directory.isHot = std::any_of(directory.files.begin(), directory.files.end(), [&](const std::pair<const std::string, PolledFile>& file) {
+				return file.second.changeTime != std::chrono::steady_clock::time_point() && now - file.second.changeTime < mHotTime;
+			});
+			directory.interval = directory.isHot ? mHotInterval : std::min(directory.interval * 2, mColdInterval);
+			directory.nextTime = now + directory.interval;
 		}
+
+		mStatistics.fileSystemCalls += calls;
 	}
+}
 
-	// Create
-	ID3D11PixelShader* pixelShader = nullptr;
-	auto res = info.renderDevices.mRenderDevice->CreatePixelShader(shader->GetBufferPointer(), shader->GetBufferSize(), nullptr, &pixelShader);
-	if (FAILED(res))
+/// <summary>
+/// Process-wide diagnostics channel
+/// </summary>
+/// <returns>Diagnostics</returns>
+inline ShaderDiagnostics& GetShaderDiagnostics()
+{
+	static ShaderDiagnostics diagnostics;
+	return diagnostics;
+}
+
+inline ShaderTracer::ShaderTracer()
+{
+	bIsEnabled = false;
+	mBufferSize = 16384;
+	mStartTime = std::chrono::steady_clock::now();
+}
+
+/// <summary>
+/// Start or stop recording
+/// </summary>
+/// <param name="isEnabled">Is recording</param>
+inline void ShaderTracer::SetEnabled(bool isEnabled)
+{
+	bIsEnabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Is recording
+/// </summary>
+/// <returns></returns>
+inline bool ShaderTracer::IsEnabled()
+{
+	return bIsEnabled.load(std::memory_order_relaxed);
+}
+
+/// <summary>
+/// How many last events is kept by every thread
+/// </summary>
+/// <param name="eventCount">Events in ring buffer, at least 1</param>
+inline void ShaderTracer::SetBufferSize(unsigned int eventCount)
+{
+	mBufferSize = eventCount ? eventCount : 1;
+}
+
+/// <summary>
+/// Microseconds from tracer creation
+/// </summary>
+/// <returns></returns>
+inline unsigned long long ShaderTracer::GetMicroseconds()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - mStartTime).count();
+}
+
+/// <summary>
+/// Buffer of calling thread, created on first event
+/// </summary>
+/// <returns>Buffer</returns>
+inline ShaderTracer::ThreadBuffer* ShaderTracer::GetThreadBuffer()
+{
+	// Tracer is process-wide, so one buffer per thread is enough
+	thread_local std::shared_ptr<ThreadBuffer> buffer;
+	if (!buffer)
 	{
-		shader->Release();
-		return false;
+		buffer = std::make_shared<ThreadBuffer>();
+		buffer->threadId = GetCurrentThreadId();
+		buffer->events.resize(mBufferSize);
+		buffer->written = 0;
+
+		std::lock_guard<std::mutex> lock(mBuffersMutex);
+		mBuffers.push_back(buffer);
 	}
+	return buffer.get();
+}
 
-	mCompiledShaders.push_back({ HotReloadableShaderType::PixelShader });
-	bIsCompiled = true;
+/// <summary>
+/// Record finished stage, oldest event of thread is overwritten when buffer is full
+/// </summary>
+/// <param name="stage">Stage name, must be static string</param>
+/// <param name="localName">Bundle, can be nullptr</param>
+/// <param name="start">Start from GetMicroseconds</param>
+/// <param name="end">End from GetMicroseconds</param>
+inline void ShaderTracer::Record(const char* stage, const char* localName, unsigned long long start, unsigned long long end)
+{
+	if (!IsEnabled())
+		return;
 
-	// save
-	mCompiledShadersA[info.localName] = pixelShader;
+	auto buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer->mutex);
 
-	return true;
+	auto& event = buffer->events[buffer->written % buffer->events.size()];
+	event.stage = stage;
+	event.localName[0] = 0;
+	if (localName)
+		strncpy_s(event.localName, sizeof(event.localName), localName, _TRUNCATE);
+	event.start = start;
+	event.duration = end - start;
+	buffer->written++;
 }
 
 /// <summary>
-/// Create vertex shader
+/// Remove recorded events of all threads
 /// </summary>
-/// <param name="info">Shader information</param>
-/// <param name="shader">shader blob</param>
-/// <returns></returns>
-inline bool HotReloadableShaders::CreateVertexShader(ShaderInformation& info, ID3DBlob* shader)
+inline void ShaderTracer::Clear()
+{
+	std::lock_guard<std::mutex> lock(mBuffersMutex);
+	for (auto& buffer : mBuffers)
+	{
+		std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+		buffer->written = 0;
+	}
+}
+
+/// <summary>
+/// Escape string for JSON
+/// </summary>
+/// <param name="value">String</param>
+/// <returns>Escaped string without quotes</returns>
+inline std::string EscapeJsonString(const char* value)
 {
-	auto sh = mCompiledShadersA.find(info.localName);
-	if (sh != mCompiledShadersA.end())
+	std::string result;
+	for (; value && *value; value++)
 	{
-		if (sh->second)
+		auto c = (unsigned char)*value;
+		if (c == '"' || c == '\\')
+		{
+			result += '\\';
+			result += (char)c;
+		}
+		else if (c < 0x20)
 		{
-			mCompiledShadersA[info.localName]->Release();
-			mCompiledShadersA[info.localName] = nullptr;
+			char code[8] = {};
+			sprintf_s(code, sizeof(code), "\\u%04x", c);
+			result += code;
 		}
+		else
+			result += (char)c;
 	}
+	return result;
+}
 
-	// Create
-	ID3D11VertexShader* vertexShader = nullptr;
-	auto res = info.renderDevices.mRenderDevice->CreateVertexShader(shader->GetBufferPointer(), shader->GetBufferSize(), nullptr, &vertexShader);
-	if (FAILED(res))
+/// <summary>
+/// Build Chrome trace JSON from all threads
+/// </summary>
+/// <returns>JSON in Trace Event Format</returns>
+inline std::string ShaderTracer::ExportChromeTrace()
+{
+	auto processId = GetCurrentProcessId();
+
+	std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool isFirst = true;
+	char line[256] = {};
+
+	std::lock_guard<std::mutex> lock(mBuffersMutex);
+	for (auto& buffer : mBuffers)
 	{
-		shader->Release();
-		return false;
+		// Copy, so producer waits only for memcpy
+		std::vector<ShaderTraceEvent> events;
+		{
+			std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+			auto size = buffer->events.size();
+			auto count = (size_t)std::min<unsigned long long>(buffer->written, size);
+			for (size_t i = 0; i < count; i++)
+				events.push_back(buffer->events[(buffer->written - count + i) % size]);
+		}
+
+		sprintf_s(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lu,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}",
+			isFirst ? "" : ",", (unsigned long)processId, buffer->threadId, buffer->threadId);
+		json += line;
+		isFirst = false;
+
+		for (auto& event : events)
+		{
+			sprintf_s(line, sizeof(line), ",{\"name\":\"%s\",\"cat\":\"HotReloadableShaders\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":%lu,\"tid\":%u",
+				event.stage, event.start, event.duration, (unsigned long)processId, buffer->threadId);
+			json += line;
+
+			if (event.localName[0])
+				json += ",\"args\":{\"shader\":\"" + EscapeJsonString(event.localName) + "\"}";
+			json += "}";
+		}
 	}
 
-	mCompiledShaders.push_back({ HotReloadableShaderType::VertexShader });
-	bIsCompiled = true;
+	json += "]}";
+	return json;
+}
 
-	// Save
-	mCompiledShadersA[info.localName] = vertexShader;
-	return true;
+/// <summary>
+/// Write Chrome trace JSON in file
+/// </summary>
+/// <param name="path">Path to .json</param>
+/// <returns>false if file is not written</returns>
+inline bool ShaderTracer::ExportChromeTrace(const char* path)
+{
+	auto json = ExportChromeTrace();
+
+	FILE* f = nullptr;
+	fopen_s(&f, path, "wb");
+	if (!f)
+		return false;
+
+	bool isWritten = fwrite(json.data(), 1, json.size(), f) == json.size();
+	fclose(f);
+	return isWritten;
+}
+
+/// <summary>
+/// Process-wide tracer
+/// </summary>
+/// <returns>Tracer</returns>
+inline ShaderTracer& GetShaderTracer()
+{
+	static ShaderTracer tracer;
+	return tracer;
+}
+
+/// <summary>
+/// Start scope, nothing is done when tracer is disabled
+/// </summary>
+/// <param name="stage">Stage name, must be static string</param>
+/// <param name="localName">Bundle, can be nullptr</param>
+inline ShaderTraceScope::ShaderTraceScope(const char* stage, const char* localName)
+{
+	mStage = stage;
+	mLocalName = localName;
+	mStart = 0;
+#if HOT_RELOADABLE_SHADERS_TRACE
+	bIsEnabled = GetShaderTracer().IsEnabled();
+	if (bIsEnabled)
+		mStart = GetShaderTracer().GetMicroseconds();
+#else
+	bIsEnabled = false;
+#endif
 }
 
+/// <summary>
+/// Record scope
+/// </summary>
+inline ShaderTraceScope::~ShaderTraceScope()
+{
+	if (bIsEnabled)
+		GetShaderTracer().Record(mStage, mLocalName, mStart, GetShaderTracer().GetMicroseconds());
+}
 
 #endif // !HotReloadableShades_h
@@ -0,0 +1,544 @@
+/*
+
+	Copyright 2026 Sergey Naumenkov
+
+	File: ShaderBuilder.cpp
+	Description: Offline shaders builder
+	Note: Compile all bundles from manifest with the same compile path as HotReloadableShaders,
+		  write .cso files and persisted cache, so runtime starts with warm cache.
+
+		  Usage: ShaderBuilder <manifest> [-cache <dir>] [-jobs <count>] [-report <file>] [-archive <file>] [-trace <file>] [-strip] [-nocompress] | -selftest
+		  -strip - strip debug info and reflection from .cso and archive, reflection metadata is written in .refl files.
+		  -nocompress - archive bytecode is not compressed.
+		  -selftest - check token hash and bytecode compression, nothing is built.
+
+		  Manifest format (one bundle per line, '#' - comment):
+		  <localName> <vs|ps|gs|hs|ds|cs> <shaderVersion|-> <entryPoint> <hlslPath>
+		  '-' as shaderVersion - default profile of stage.
+		  Paths are relative to manifest file.
+
+	Date: 18/10/2026
+
+*/
+
+#include <windows.h>
+#include <cstdio>
+#include <string>
+#include <sstream>
+#include <fstream>
+
+#include "HotReloadableShaders.h"
+
+// One bundle from manifest
+struct ManifestBundle
+{
+	std::string localName;
+	std::string type;
+	std::string shaderVersion;
+	std::string entryPoint;
+	std::string hlslPath;
+
+	ShaderInformation information;
+};
+
+// Result of building one bundle
+struct BuildResult
+{
+	bool isBuilt;
+	bool isFromCache;
+	double milliseconds;
+	size_t bytecodeSize;
+	size_t strippedSize;
+	size_t compressedSize;
+
+	// For packed archive
+	PreprocessedShader preprocessed;
+	ShaderArchiveFile source;
+	std::vector<unsigned char> bytecode;
+};
+
+// Builder options
+struct BuildOptions
+{
+	std::string manifestPath;
+	std::string cacheDirectory;
+	std::string reportPath;
+	std::string archivePath;
+	std::string tracePath;
+	unsigned int jobs;
+	bool isStripMode;
+	bool isCompression;
+	bool isSelfTest;
+};
+
+/// <summary>
+/// Get directory of file path (with last slash)
+/// </summary>
+/// <param name="path">File path</param>
+/// <returns>Directory</returns>
+static std::string GetDirectory(const std::string& path)
+{
+	auto slash = path.find_last_of("/\\");
+	if (slash == std::string::npos)
+		return "";
+
+	return path.substr(0, slash + 1);
+}
+
+/// <summary>
+/// Is path absolute
+/// </summary>
+/// <param name="path">Path</param>
+/// <returns></returns>
+static bool IsAbsolutePath(const std::string& path)
+{
+	return (path.size() > 1 && path[1] == ':') || (!path.empty() && (path[0] == '/' || path[0] == '\\'));
+}
+
+/// <summary>
+/// Parse manifest file
+/// </summary>
+/// <param name="path">Path to manifest</param>
+/// <param name="bundles">out bundles</param>
+/// <returns>true if parsed</returns>
+static bool ParseManifest(const std::string& path, std::vector<ManifestBundle>& bundles)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		printf("Failed open manifest <%s>!\n", path.c_str());
+		return false;
+	}
+
+	auto directory = GetDirectory(path);
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		// Skip comments and empty lines
+		auto comment = line.find('#');
+		if (comment != std::string::npos)
+			line.erase(comment);
+
+		std::istringstream stream(line);
+		ManifestBundle bundle;
+		if (!(stream >> bundle.localName))
+			continue;
+
+		if (!(stream >> bundle.type >> bundle.shaderVersion >> bundle.entryPoint >> bundle.hlslPath))
+		{
+			printf("Manifest <%s> line %i: expected <localName> <vs|ps|gs|hs|ds|cs> <shaderVersion|-> <entryPoint> <hlslPath>\n", path.c_str(), lineNumber);
+			return false;
+		}
+
+		if (!IsAbsolutePath(bundle.hlslPath))
+			bundle.hlslPath = directory + bundle.hlslPath;
+
+		bundle.information = {};
+		if (bundle.type == "vs")
+			bundle.information.localShaderType = HotReloadableShaderType::VertexShader;
+		else if (bundle.type == "ps")
+			bundle.information.localShaderType = HotReloadableShaderType::PixelShader;
+		else if (bundle.type == "gs")
+			bundle.information.localShaderType = HotReloadableShaderType::GeometryShader;
+		else if (bundle.type == "hs")
+			bundle.information.localShaderType = HotReloadableShaderType::HullShader;
+		else if (bundle.type == "ds")
+			bundle.information.localShaderType = HotReloadableShaderType::DomainShader;
+		else if (bundle.type == "cs")
+			bundle.information.localShaderType = HotReloadableShaderType::ComputeShader;
+		else
+		{
+			printf("Manifest <%s> line %i: unknown shader type <%s>\n", path.c_str(), lineNumber, bundle.type.c_str());
+			return false;
+		}
+
+		bundle.information.bSaveToCSO = true;
+		bundles.push_back(bundle);
+	}
+
+	// Strings is owned by bundles, set pointers after vector is filled
+	for (auto& bundle : bundles)
+	{
+		bundle.information.localName = bundle.localName.c_str();
+		bundle.information.shaderVersion = bundle.shaderVersion == "-" ? nullptr : bundle.shaderVersion.c_str();
+		bundle.information.entryPoint = bundle.entryPoint.c_str();
+		bundle.information.hlslPath = bundle.hlslPath.c_str();
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Parse command line
+/// </summary>
+/// <returns>true if parsed</returns>
+static bool ParseOptions(int argc, char** argv, BuildOptions& options)
+{
+	options.jobs = 0;
+	options.isStripMode = false;
+	options.isCompression = true;
+	options.isSelfTest = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "-cache" && i + 1 < argc)
+			options.cacheDirectory = argv[++i];
+		else if (arg == "-jobs" && i + 1 < argc)
+			options.jobs = (unsigned int)atoi(argv[++i]);
+		else if (arg == "-report" && i + 1 < argc)
+			options.reportPath = argv[++i];
+		else if (arg == "-archive" && i + 1 < argc)
+			options.archivePath = argv[++i];
+		else if (arg == "-trace" && i + 1 < argc)
+			options.tracePath = argv[++i];
+		else if (arg == "-strip")
+			options.isStripMode = true;
+		else if (arg == "-nocompress")
+			options.isCompression = false;
+		else if (arg == "-selftest")
+			options.isSelfTest = true;
+		else if (options.manifestPath.empty() && arg[0] != '-')
+			options.manifestPath = arg;
+		else
+			return false;
+	}
+
+	return options.isSelfTest || !options.manifestPath.empty();
+}
+
+/// <summary>
+/// Is file exist
+/// </summary>
+static bool IsFileExist(const std::string& path)
+{
+	WIN32_FIND_DATAA findData;
+	auto handle = FindFirstFileA(path.c_str(), &findData);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	FindClose(handle);
+	return true;
+}
+
+/// <summary>
+/// Build one bundle
+/// </summary>
+static BuildResult BuildBundle(const ManifestBundle& bundle, ShaderCache& cache, bool isStripMode)
+{
+	BuildResult result = {};
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<unsigned char> source;
+	bool isRead = false;
+	{
+		ShaderTraceScope trace("Read", bundle.information.localName);
+		isRead = ReadFile(bundle.hlslPath.c_str(), source);
+	}
+
+	if (isRead)
+	{
+		// Archive entry is valid while .hlsl has same content, size and time is checked before content
+		result.source.contentHash = HashBytes(source.data(), source.size());
+		result.source.size = source.size();
+		GetFileWriteTime(bundle.hlslPath.c_str(), result.source.writeTime);
+
+		auto& bytecode = result.bytecode;
+		result.isBuilt = PreprocessShader(bundle.information, source, result.preprocessed) &&
+			CompileShaderBytecode(bundle.information, result.preprocessed, &cache, bytecode, &result.isFromCache);
+		result.bytecodeSize = bytecode.size();
+
+		// Size of shipped bytecode
+		std::vector<unsigned char> stripped;
+		if (result.isBuilt && isStripMode && StripShaderBytecode(bytecode.data(), bytecode.size(), stripped))
+			result.strippedSize = stripped.size();
+		else
+			result.strippedSize = bytecode.size();
+
+		std::vector<unsigned char> compressed;
+		if (result.isBuilt)
+			CompressShaderBytes(stripped.empty() ? bytecode.data() : stripped.data(), result.strippedSize, compressed);
+		result.compressedSize = compressed.size();
+
+		// Incremental: .cso from cache is only written when it is missing
+		bool isMissing = !IsFileExist(GetCSOPath(bundle.hlslPath.c_str())) ||
+			(isStripMode && !IsFileExist(GetReflectionPath(bundle.hlslPath.c_str())));
+		if (result.isBuilt && (!result.isFromCache || isMissing))
+		{
+			ShaderTraceScope trace("WriteCSO", bundle.information.localName);
+			if (isStripMode)
+				result.isBuilt = WriteStrippedCSOFile(bundle.hlslPath.c_str(), bytecode.data(), bytecode.size());
+			else
+				result.isBuilt = WriteCSOFile(bundle.hlslPath.c_str(), bytecode.data(), bytecode.size());
+		}
+	}
+	else
+	{
+		printf("Failed read <%s>!\n", bundle.hlslPath.c_str());
+	}
+
+	result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+/// <summary>
+/// Measure decompression speed of shipped bytecode
+/// </summary>
+/// <returns>Megabytes of decompressed bytecode per second</returns>
+static double MeasureDecodeThroughput(const std::vector<ManifestBundle>& bundles, const std::vector<BuildResult>& results, bool isStripMode)
+{
+	std::vector<std::vector<unsigned char>> streams;
+	std::vector<size_t> sizes;
+	size_t maxSize = 0;
+	for (size_t i = 0; i < bundles.size(); i++)
+	{
+		auto& bytecode = results[i].bytecode;
+		if (!results[i].isBuilt || bytecode.empty())
+			continue;
+
+		std::vector<unsigned char> stripped;
+		if (!isStripMode || !StripShaderBytecode(bytecode.data(), bytecode.size(), stripped))
+			stripped = bytecode;
+
+		streams.emplace_back();
+		CompressShaderBytes(stripped.data(), stripped.size(), streams.back());
+		sizes.push_back(stripped.size());
+		maxSize = std::max(maxSize, stripped.size());
+	}
+	if (streams.empty())
+		return 0.0;
+
+	// Repeat until time is measurable
+	std::vector<unsigned char> output(maxSize);
+	unsigned long long decodedBytes = 0;
+	auto start = std::chrono::steady_clock::now();
+	double seconds = 0.0;
+	while (seconds < 0.2)
+	{
+		for (size_t i = 0; i < streams.size(); i++)
+		{
+			if (!DecompressShaderBytes(streams[i].data(), streams[i].size(), output.data(), sizes[i]))
+				return 0.0;
+			decodedBytes += sizes[i];
+		}
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	return decodedBytes / seconds / (1024.0 * 1024.0);
+}
+
+/// <summary>
+/// Print result of one self test check
+/// </summary>
+/// <returns>Result</returns>
+static bool CheckSelfTest(bool isPassed, const char* name)
+{
+	printf("  %-56s %s\n", name, isPassed ? "ok" : "FAILED");
+	return isPassed;
+}
+
+/// <summary>
+/// Self test of token hash and bytecode compression, they decide what is recompiled and what is loaded from archive
+/// </summary>
+/// <returns>true if all checks is passed</returns>
+static bool RunSelfTest()
+{
+	bool isPassed = true;
+	auto hash = [](const std::string& text) { return HashShaderTokens(text.data(), text.size()); };
+
+	printf("Token hash:\n");
+	std::string code = "#line 1 \"a.hlsl\"\nfloat4 main(float4 p : POSITION) : SV_Position\n{\n\treturn p * 2.0f;\n}\n";
+	// Comment is removed by preprocessor, only empty lines and #line are left
+	std::string commented = "#line 1 \"a.hlsl\"\n\n\n#line 4 \"a.hlsl\"\nfloat4 main(float4 p:POSITION) : SV_Position\n{\n    return p*2.0f;\n\n}\n";
+	std::string changed = "#line 1 \"a.hlsl\"\nfloat4 main(float4 p : POSITION) : SV_Position\n{\n\treturn p * 3.0f;\n}\n";
+	isPassed &= CheckSelfTest(hash(code) == hash(commented), "comment and formatting change keeps hash");
+	isPassed &= CheckSelfTest(hash(code) != hash(changed), "token change changes hash");
+	isPassed &= CheckSelfTest(hash("int a = b - -c;") != hash("int a = b --c;"), "space between punctuators is matter");
+	isPassed &= CheckSelfTest(hash("int a b;") != hash("int ab;"), "space between words is matter");
+	isPassed &= CheckSelfTest(hash("s = \"a  b\";") != hash("s = \"a b\";"), "string literal is hashed as is");
+
+	printf("Bytecode compression:\n");
+	std::vector<std::vector<unsigned char>> inputs(4);
+	unsigned int seed = 12345;
+	auto random = [&seed]() { seed = seed * 1664525u + 1013904223u; return (unsigned char)(seed >> 24); };
+	inputs[1].assign(100, 'x');
+	for (size_t i = 0; i < 3 * ShaderCompressionBlockSize + 17; i++)
+		inputs[2].push_back((unsigned char)((i % 251) ^ (i / 4096)));
+	for (size_t i = 0; i < ShaderCompressionBlockSize + 5; i++)
+		inputs[3].push_back(random());
+
+	for (auto& input : inputs)
+	{
+		std::vector<unsigned char> compressed;
+		CompressShaderBytes(input.data(), input.size(), compressed);
+		std::vector<unsigned char> output(input.size() + 1);
+		char name[64] = {};
+		sprintf_s(name, sizeof(name), "round trip of %zu bytes", input.size());
+		isPassed &= CheckSelfTest(DecompressShaderBytes(compressed.data(), compressed.size(), output.data(), input.size()) &&
+			std::equal(input.begin(), input.end(), output.begin()), name);
+		if (input.empty())
+			continue;
+
+		// Every cut of stream is detected
+		bool isDetected = true;
+		for (size_t size = 0; size < compressed.size(); size += std::max<size_t>(1, compressed.size() / 512))
+			isDetected &= !DecompressShaderBytes(compressed.data(), size, output.data(), input.size());
+		sprintf_s(name, sizeof(name), "truncated stream of %zu bytes is rejected", input.size());
+		isPassed &= CheckSelfTest(isDetected, name);
+
+		// Other size of output is detected
+		isPassed &= CheckSelfTest(!DecompressShaderBytes(compressed.data(), compressed.size(), output.data(), input.size() - 1) &&
+			!DecompressShaderBytes(compressed.data(), compressed.size(), output.data(), input.size() + 1), "wrong output size is rejected");
+
+		// Damaged bytes can be decoded into other bytes, but never outside of output
+		bool isInside = true;
+		for (int i = 0; i < 256; i++)
+		{
+			auto damaged = compressed;
+			damaged[(random() | (random() << 8) | (random() << 16)) % damaged.size()] ^= (unsigned char)(1 << (i & 7));
+			output.assign(input.size() + 64, 0xCD);
+			DecompressShaderBytes(damaged.data(), damaged.size(), output.data(), input.size());
+			isInside &= std::all_of(output.begin() + input.size(), output.end(), [](unsigned char c) { return c == 0xCD; });
+		}
+		isPassed &= CheckSelfTest(isInside, "damaged stream is not written outside of output");
+	}
+
+	// Hand made blocks: match before start of output and size bigger than stream
+	unsigned char badOffset[] = { 6, 0, 0, 0, 0x10, 'a', 5, 0, 'b', 'c' };
+	unsigned char badSize[] = { 0xFF, 0, 0, 0, 0x10, 'a' };
+	unsigned char badStored[] = { 3, 0, 0, 0x80, 'a', 'b', 'c' };
+	unsigned char output[64] = {};
+	isPassed &= CheckSelfTest(!DecompressShaderBytes(badOffset, sizeof(badOffset), output, 7), "match offset before output is rejected");
+	isPassed &= CheckSelfTest(!DecompressShaderBytes(badSize, sizeof(badSize), output, 1), "block size bigger than stream is rejected");
+	isPassed &= CheckSelfTest(!DecompressShaderBytes(badStored, sizeof(badStored), output, 2), "stored block bigger than output is rejected");
+
+	printf(isPassed ? "Self test is passed\n" : "Self test is FAILED\n");
+	return isPassed;
+}
+
+int main(int argc, char** argv)
+{
+	BuildOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		printf("Usage: ShaderBuilder <manifest> [-cache <dir>] [-jobs <count>] [-report <file>] [-archive <file>] [-trace <file>] [-strip] [-nocompress] | -selftest\n");
+		return 2;
+	}
+
+	if (options.isSelfTest)
+		return RunSelfTest() ? 0 : 1;
+
+	std::vector<ManifestBundle> bundles;
+	if (!ParseManifest(options.manifestPath, bundles))
+		return 1;
+
+	// Chrome trace of all stages
+	if (!options.tracePath.empty())
+		GetShaderTracer().SetEnabled(true);
+
+	ShaderCache cache;
+	if (!options.cacheDirectory.empty())
+		cache.SetDirectory(options.cacheDirectory.c_str());
+
+	// Compile all bundles in parallel
+	std::vector<BuildResult> results(bundles.size());
+	auto start = std::chrono::steady_clock::now();
+	{
+		ShaderJobScheduler scheduler(options.jobs);
+		for (size_t i = 0; i < bundles.size(); i++)
+		{
+			scheduler.Submit([&, i]() { results[i] = BuildBundle(bundles[i], cache, options.isStripMode); });
+		}
+		scheduler.Wait();
+
+		auto statistics = scheduler.GetStatistics();
+		printf("Built %zu bundles on %u threads, utilization %.0f%%\n", bundles.size(), statistics.threadCount, statistics.utilization * 100.0);
+	}
+	double wallMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// Compile errors first, then report
+	GetShaderDiagnostics().Flush();
+
+	// Timing report
+	FILE* report = nullptr;
+	if (!options.reportPath.empty())
+	{
+		fopen_s(&report, options.reportPath.c_str(), "w");
+		if (!report)
+			printf("Failed create report <%s>!\n", options.reportPath.c_str());
+		else
+			fprintf(report, "localName,status,milliseconds,bytecodeSize,strippedSize,compressedSize\n");
+	}
+
+	int failedCount = 0;
+	int cachedCount = 0;
+	double totalMilliseconds = 0.0;
+	size_t totalBytecodeSize = 0;
+	size_t totalStrippedSize = 0;
+	size_t totalCompressedSize = 0;
+	for (size_t i = 0; i < bundles.size(); i++)
+	{
+		auto& result = results[i];
+		const char* status = !result.isBuilt ? "failed" : result.isFromCache ? "cached" : "compiled";
+		failedCount += result.isBuilt ? 0 : 1;
+		cachedCount += result.isFromCache ? 1 : 0;
+		totalMilliseconds += result.milliseconds;
+		totalBytecodeSize += result.bytecodeSize;
+		totalStrippedSize += result.strippedSize;
+		totalCompressedSize += result.compressedSize;
+
+		printf("  %-32s %-8s %9.2f ms %8zu bytes\n", bundles[i].localName.c_str(), status, result.milliseconds, result.bytecodeSize);
+		if (report)
+			fprintf(report, "%s,%s,%.3f,%zu,%zu,%zu\n", bundles[i].localName.c_str(), status, result.milliseconds, result.bytecodeSize, result.strippedSize, result.compressedSize);
+	}
+
+	printf("Total: %zu bundles, %i from cache, %i failed, wall %.2f ms, sum %.2f ms\n",
+		bundles.size(), cachedCount, failedCount, wallMilliseconds, totalMilliseconds);
+
+	// Shared headers is read once for all bundles
+	auto includes = GetShaderIncludeCache().GetStatistics();
+	auto includeRequests = includes.hits + includes.misses;
+	printf("Includes: %llu opened, %.1f%% from memory, %llu bytes read, %llu bytes saved\n",
+		includeRequests, includeRequests ? 100.0 * includes.hits / includeRequests : 0.0, includes.bytesRead, includes.bytesSaved);
+
+	// Stored size and how fast it is decompressed on load
+	auto percent = [totalBytecodeSize](size_t size) { return totalBytecodeSize ? 100.0 * size / totalBytecodeSize : 0.0; };
+	printf("Bytecode: %zu bytes, stripped %zu bytes (%.1f%%), compressed %zu bytes (%.1f%%), decode %.1f MB/s\n",
+		totalBytecodeSize, totalStrippedSize, percent(totalStrippedSize), totalCompressedSize, percent(totalCompressedSize),
+		MeasureDecodeThroughput(bundles, results, options.isStripMode));
+
+	if (report)
+		fclose(report);
+
+	// Pack all compiled shaders in one archive
+	if (!options.archivePath.empty())
+	{
+		ShaderArchiveWriter archive;
+		archive.SetStripMode(options.isStripMode);
+		archive.SetCompression(options.isCompression);
+		for (size_t i = 0; i < bundles.size(); i++)
+		{
+			if (results[i].isBuilt)
+				archive.Add(bundles[i].information, results[i].preprocessed, results[i].source, results[i].bytecode);
+		}
+
+		if (!archive.Write(options.archivePath.c_str()))
+			return 1;
+
+		printf("Archive <%s> is written\n", options.archivePath.c_str());
+	}
+
+	if (!options.tracePath.empty())
+	{
+		if (!GetShaderTracer().ExportChromeTrace(options.tracePath.c_str()))
+			printf("Failed write trace <%s>!\n", options.tracePath.c_str());
+		else
+			printf("Trace <%s> is written\n", options.tracePath.c_str());
+	}
+
+	return failedCount ? 1 : 0;
+}
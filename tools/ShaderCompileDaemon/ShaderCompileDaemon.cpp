@@ -0,0 +1,607 @@
+/*
+
+	Copyright 2026 Sergey Naumenkov
+
+	File: ShaderCompileDaemon.cpp
+	Description: Out-of-process compile service for HotReloadableShaders
+	Note: Several processes (editor, game client, tools) subscribe the same shaders,
+		  service watches every file once, compiles it once and sends bytecode or errors to all subscribers.
+		  Compiled bytecode is stored in shared persisted cache.
+
+		  Usage: ShaderCompileDaemon [-pipe <name>] [-cache <dir>] [-jobs <count>]
+		  Client: HotReloadableShaders::ConnectToCompileService()
+		  Ctrl+C stops service: clients is disconnected and all threads is joined
+
+	Date: 18/10/2026
+
+*/
+
+#include <windows.h>
+#include <cstdio>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <deque>
+#include <atomic>
+
+#include "HotReloadableShaders.h"
+
+// Connected process
+// Pipe is overlapped: reads of client thread and writes of writer thread never wait each other
+struct ServiceClient
+{
+	HANDLE pipe;
+	std::atomic<bool> isConnected;
+
+	// Results which is not written yet, latest one per local name.
+	// Only writer thread of client waits its pipe, so process which is not reading (paused, in debugger) blocks nobody
+	std::mutex queueMutex;
+	std::condition_variable queueChanged;
+	std::deque<std::pair<std::string, std::vector<unsigned char>>> queue;
+	std::thread writer;
+
+	// Client thread is finished, it can be joined
+	std::atomic<bool> isFinished;
+};
+
+// Process which is waiting results of job
+struct ServiceSubscriber
+{
+	std::shared_ptr<ServiceClient> client;
+	std::string localName;
+};
+
+// One unique shader (file + entry point + shader version + flags), compiled once for all subscribers
+struct CompileJob
+{
+	std::string hlslPath;
+	std::string entryPoint;
+	std::string shaderVersion;
+	unsigned int shaderType;
+	unsigned int flags;
+
+	// Watch state
+	unsigned long long writeTime;
+	std::map<std::string, unsigned long long> dependencies;
+	// Normalized paths of .hlsl and included files, used only by watch thread
+	std::vector<std::string> watchedPaths;
+
+	// Last result
+	bool hasResult;
+	bool isSucceeded;
+	unsigned long long tokenHash;
+	std::vector<unsigned char> bytecode;
+	std::string errorMessage;
+
+	std::vector<ServiceSubscriber> subscribers;
+};
+
+// Result of job for sending, copied under jobs lock and sent after it
+struct ServiceResult
+{
+	bool isSucceeded;
+	unsigned long long tokenHash;
+	std::vector<unsigned char> bytecode;
+	std::string errorMessage;
+};
+
+// Service state
+static std::mutex gJobsMutex;
+static std::map<std::string, std::shared_ptr<CompileJob>> gJobs;
+static ShaderCache gCache;
+
+// Watch thread is woken by new job or stop, jobs lock is used
+static std::condition_variable gJobsChanged;
+static bool gIsStopping = false;
+
+// Manual-reset event, set by Ctrl+C: every wait of pipe is cancelled
+static HANDLE gStopEvent = NULL;
+
+/// <summary>
+/// Copy last result of job
+/// </summary>
+static std::shared_ptr<ServiceResult> GetJobResult(const CompileJob& job)
+{
+	auto result = std::make_shared<ServiceResult>();
+	result->isSucceeded = job.isSucceeded;
+	result->tokenHash = job.tokenHash;
+	result->bytecode = job.bytecode;
+	result->errorMessage = job.errorMessage;
+	return result;
+}
+
+/// <summary>
+/// Queue result for one subscriber, it is written by writer thread of client
+/// Result which is not written yet is replaced, process needs only latest one
+/// </summary>
+static void SendResult(const ServiceResult& result, const ServiceSubscriber& subscriber)
+{
+	ShaderServiceMessage message;
+	message.PutString(subscriber.localName.c_str());
+	message.PutUInt(result.isSucceeded ? 1 : 0);
+	message.PutUInt64(result.tokenHash);
+	message.PutBytes(result.bytecode.data(), result.bytecode.size());
+	message.PutString(result.errorMessage.c_str());
+	auto packet = message.Pack(ShaderServiceMessageType::Result);
+
+	auto& client = *subscriber.client;
+	std::lock_guard<std::mutex> lock(client.queueMutex);
+	if (!client.isConnected)
+		return;
+
+	auto queued = std::find_if(client.queue.begin(), client.queue.end(),
+		[&](const std::pair<std::string, std::vector<unsigned char>>& item) { return item.first == subscriber.localName; });
+	if (queued != client.queue.end())
+		queued->second.swap(packet);
+	else
+		client.queue.push_back({ subscriber.localName, std::move(packet) });
+
+	client.queueChanged.notify_one();
+}
+
+/// <summary>
+/// Wait overlapped operation on pipe, operation is cancelled when service is stopping
+/// </summary>
+/// <param name="isDone">Result of ReadFile, WriteFile or ConnectNamedPipe</param>
+/// <returns>false if operation is failed or cancelled</returns>
+static bool WaitPipeOperation(HANDLE pipe, OVERLAPPED& overlapped, BOOL isDone, DWORD& bytes)
+{
+	if (!isDone && GetLastError() != ERROR_IO_PENDING)
+		return false;
+
+	HANDLE events[] = { overlapped.hEvent, gStopEvent };
+	if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0)
+	{
+		// Buffer is used by system until operation is finished
+		CancelIoEx(pipe, &overlapped);
+		GetOverlappedResult(pipe, &overlapped, &bytes, TRUE);
+		return false;
+	}
+
+	return GetOverlappedResult(pipe, &overlapped, &bytes, FALSE) != FALSE;
+}
+
+/// <summary>
+/// Write queued results of one process
+/// </summary>
+static void WriterLoop(ServiceClient* client)
+{
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+	while (true)
+	{
+		std::vector<unsigned char> packet;
+		{
+			std::unique_lock<std::mutex> lock(client->queueMutex);
+			client->queueChanged.wait(lock, [client]() { return !client->isConnected || !client->queue.empty(); });
+			if (!client->isConnected)
+				break;
+
+			packet.swap(client->queue.front().second);
+			client->queue.pop_front();
+		}
+
+		ResetEvent(overlapped.hEvent);
+		DWORD bytes = 0;
+		BOOL isDone = ::WriteFile(client->pipe, packet.data(), (DWORD)packet.size(), NULL, &overlapped);
+		if (!WaitPipeOperation(client->pipe, overlapped, isDone, bytes) || bytes != packet.size())
+		{
+			client->isConnected = false;
+			break;
+		}
+	}
+
+	CloseHandle(overlapped.hEvent);
+}
+
+/// <summary>
+/// Is any watched file of job changed
+/// </summary>
+static bool IsJobChanged(CompileJob& job, unsigned long long& time)
+{
+	time = 0;
+	if (!GetFileWriteTime(job.hlslPath.c_str(), time))
+		return false;
+
+	if (job.writeTime != time)
+		return true;
+
+	for (auto& dependency : job.dependencies)
+	{
+		unsigned long long dependencyTime = 0;
+		GetFileWriteTime(dependency.first.c_str(), dependencyTime);
+		if (dependencyTime != dependency.second)
+			return true;
+	}
+
+	return false;
+}
+
+// New result of job, applied under jobs lock
+struct JobResult
+{
+	bool isChanged;
+	bool isSucceeded;
+	unsigned long long tokenHash;
+	std::vector<unsigned char> bytecode;
+	std::string errorMessage;
+};
+
+/// <summary>
+/// Compile job, same path as in HotReloadableShaders
+/// *Note* Result fields of job is only read here, they are written by watch thread only
+/// </summary>
+static JobResult CompileJobSource(CompileJob& job)
+{
+	JobResult result = {};
+
+	ShaderInformation info = {};
+	info.localShaderType = (HotReloadableShaderType)job.shaderType;
+	info.localName = job.hlslPath.c_str();
+	info.hlslPath = job.hlslPath.c_str();
+	info.entryPoint = job.entryPoint.c_str();
+	info.shaderVersion = job.shaderVersion.c_str();
+
+	std::vector<unsigned char> source;
+	if (!ReadFile(job.hlslPath.c_str(), source))
+		return result;
+
+	PreprocessedShader preprocessed = {};
+	if (!PreprocessShader(info, source, preprocessed, &result.errorMessage))
+	{
+		result.isChanged = true;
+		return result;
+	}
+
+	job.dependencies = preprocessed.dependencies;
+
+	// Only comments or whitespaces is changed
+	if (job.hasResult && job.isSucceeded && job.tokenHash == preprocessed.tokenHash)
+		return result;
+
+	bool isFromCache = false;
+	result.isChanged = true;
+	result.isSucceeded = CompileShaderBytecode(info, preprocessed, &gCache, result.bytecode, &isFromCache, &result.errorMessage);
+	result.tokenHash = result.isSucceeded ? preprocessed.tokenHash : 0;
+	if (result.isSucceeded)
+		result.errorMessage.clear();
+
+	printf("%s <%s> %s\n", result.isSucceeded ? (isFromCache ? "Cached" : "Compiled") : "Failed", job.hlslPath.c_str(), job.entryPoint.c_str());
+	return result;
+}
+
+/// <summary>
+/// Watch all jobs, compile changed in parallel and send results
+/// Files is checked only when directory watcher reports them (or lost events), so idle service doesn't touch file system
+/// </summary>
+static void WatchLoop(unsigned int jobs)
+{
+	ShaderJobScheduler scheduler(jobs);
+	ShaderDirectoryWatcher watcher;
+
+	while (true)
+	{
+		// Take snapshot of jobs, subscribers can be added while compiling
+		std::vector<std::shared_ptr<CompileJob>> snapshot;
+		{
+			// Watcher is not waiting, it is polled after new job, stop or timeout
+			std::unique_lock<std::mutex> lock(gJobsMutex);
+			gJobsChanged.wait_for(lock, std::chrono::milliseconds(50));
+			if (gIsStopping)
+				break;
+
+			for (auto& job : gJobs)
+				snapshot.push_back(job.second);
+		}
+
+		std::vector<std::string> changedPaths;
+		bool isEverythingChanged = !watcher.Poll(changedPaths);
+		std::sort(changedPaths.begin(), changedPaths.end());
+
+		// Included file with same write time (renamed over old one) must be read again
+		for (auto& path : changedPaths)
+			GetShaderIncludeCache().Invalidate(path.c_str());
+		if (isEverythingChanged)
+			GetShaderIncludeCache().Clear();
+
+		std::vector<std::shared_ptr<CompileJob>> changedJobs;
+		std::vector<unsigned long long> changedTimes;
+		for (auto& job : snapshot)
+		{
+			// New job: directory is watched, first compile is decided by time
+			bool isNew = job->watchedPaths.empty();
+			if (isNew)
+			{
+				watcher.WatchFileDirectory(job->hlslPath.c_str());
+				job->watchedPaths.push_back(NormalizeShaderPath(job->hlslPath.c_str()));
+			}
+
+			unsigned long long time = 0;
+			bool isChanged = false;
+			if (isNew || isEverythingChanged)
+			{
+				isChanged = IsJobChanged(*job, time);
+			}
+			else
+			{
+				auto& paths = job->watchedPaths;
+				isChanged = std::any_of(paths.begin(), paths.end(), [&](const std::string& path) { return std::binary_search(changedPaths.begin(), changedPaths.end(), path); }) &&
+					GetFileWriteTime(job->hlslPath.c_str(), time);
+			}
+
+			if (isChanged)
+			{
+				changedJobs.push_back(job);
+				changedTimes.push_back(time);
+			}
+		}
+
+		std::vector<JobResult> results(changedJobs.size());
+		for (size_t i = 0; i < changedJobs.size(); i++)
+		{
+			scheduler.Submit([&, i]() { results[i] = CompileJobSource(*changedJobs[i]); });
+		}
+		scheduler.Wait();
+
+		// Included files can be other after compile
+		for (auto& job : changedJobs)
+		{
+			job->watchedPaths.resize(1);
+			for (auto& dependency : job->dependencies)
+			{
+				watcher.WatchFileDirectory(dependency.first.c_str());
+				job->watchedPaths.push_back(NormalizeShaderPath(dependency.first.c_str()));
+			}
+		}
+
+		// Apply results, they is sent after jobs lock is released
+		std::vector<std::pair<ServiceSubscriber, std::shared_ptr<ServiceResult>>> sends;
+		{
+			std::lock_guard<std::mutex> lock(gJobsMutex);
+			for (size_t i = 0; i < changedJobs.size(); i++)
+			{
+				auto& job = *changedJobs[i];
+				auto& result = results[i];
+				job.writeTime = changedTimes[i];
+				if (!result.isChanged)
+					continue;
+
+				job.hasResult = true;
+				job.isSucceeded = result.isSucceeded;
+				job.tokenHash = result.tokenHash;
+				job.bytecode = std::move(result.bytecode);
+				job.errorMessage = std::move(result.errorMessage);
+
+				auto jobResult = GetJobResult(job);
+				for (auto& subscriber : job.subscribers)
+					sends.push_back({ subscriber, jobResult });
+			}
+
+			// Remove disconnected processes
+			for (auto& job : gJobs)
+			{
+				auto& subscribers = job.second->subscribers;
+				subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+					[](const ServiceSubscriber& subscriber) { return !subscriber.client->isConnected; }), subscribers.end());
+			}
+		}
+
+		for (auto& send : sends)
+			SendResult(*send.second, send.first);
+	}
+}
+
+/// <summary>
+/// Handle subscribe message
+/// </summary>
+static void Subscribe(const std::shared_ptr<ServiceClient>& client, ShaderServiceMessage& message)
+{
+	unsigned int shaderType = 0;
+	unsigned int flags = 0;
+	std::string localName, hlslPath, entryPoint, shaderVersion;
+	if (!message.GetUInt(shaderType) || !message.GetString(localName) || !message.GetString(hlslPath) ||
+		!message.GetString(entryPoint) || !message.GetString(shaderVersion) || !message.GetUInt(flags))
+		return;
+
+	if (!GetShaderStageFunctions((HotReloadableShaderType)shaderType))
+	{
+		printf("Subscriber <%s> has unknown shader type %u, skipped\n", localName.c_str(), shaderType);
+		return;
+	}
+
+	// Service compiles with own flags, client with other flags can't use its bytecode
+	if (flags != HOT_RELOADABLE_SHADERS_COMPILE_FLAGS)
+	{
+		printf("Subscriber <%s> has other compile flags, skipped\n", localName.c_str());
+		return;
+	}
+
+	// Paths on Windows is case insensitive
+	std::string key = hlslPath;
+	std::transform(key.begin(), key.end(), key.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+	key += "|" + entryPoint + "|" + shaderVersion + "|" + std::to_string(shaderType);
+
+	ServiceSubscriber subscriber = { client, localName };
+	std::shared_ptr<ServiceResult> result;
+	{
+		std::lock_guard<std::mutex> lock(gJobsMutex);
+		auto& job = gJobs[key];
+		if (!job)
+		{
+			job = std::make_shared<CompileJob>();
+			job->hlslPath = hlslPath;
+			job->entryPoint = entryPoint;
+			job->shaderVersion = shaderVersion;
+			job->shaderType = shaderType;
+			job->flags = flags;
+			job->writeTime = 0;
+			job->hasResult = false;
+			job->isSucceeded = false;
+			job->tokenHash = 0;
+		}
+
+		job->subscribers.push_back(subscriber);
+
+		// Already compiled for other process
+		if (job->hasResult)
+			result = GetJobResult(*job);
+	}
+	gJobsChanged.notify_one();
+
+	if (result)
+		SendResult(*result, subscriber);
+}
+
+/// <summary>
+/// Read messages of one process
+/// </summary>
+static void ClientLoop(std::shared_ptr<ServiceClient> client)
+{
+	ShaderServiceReceiver receiver;
+	std::vector<unsigned char> buffer(64 * 1024);
+
+	client->writer = std::thread(WriterLoop, client.get());
+
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+	while (true)
+	{
+		ResetEvent(overlapped.hEvent);
+		DWORD bytesRead = 0;
+		BOOL isDone = ::ReadFile(client->pipe, buffer.data(), (DWORD)buffer.size(), NULL, &overlapped);
+		if (!WaitPipeOperation(client->pipe, overlapped, isDone, bytesRead) || bytesRead == 0)
+			break;
+
+		receiver.Append(buffer.data(), bytesRead);
+
+		ShaderServiceMessageType type;
+		ShaderServiceMessage message;
+		while (receiver.Next(type, message))
+		{
+			if (type == ShaderServiceMessageType::Subscribe)
+				Subscribe(client, message);
+		}
+
+		if (receiver.IsBroken())
+			break;
+	}
+
+	// Stop writer, write which is waiting for process is cancelled
+	{
+		std::lock_guard<std::mutex> lock(client->queueMutex);
+		client->isConnected = false;
+		client->queue.clear();
+	}
+	client->queueChanged.notify_one();
+	CancelIoEx(client->pipe, NULL);
+	client->writer.join();
+
+	CloseHandle(overlapped.hEvent);
+	DisconnectNamedPipe(client->pipe);
+	CloseHandle(client->pipe);
+	client->pipe = INVALID_HANDLE_VALUE;
+
+	printf("Client is disconnected\n");
+	client->isFinished = true;
+}
+
+/// <summary>
+/// Ctrl+C, Ctrl+Break or closed console: stop service
+/// </summary>
+static BOOL WINAPI OnConsoleControl(DWORD type)
+{
+	SetEvent(gStopEvent);
+	return TRUE;
+}
+
+int main(int argc, char** argv)
+{
+	std::string pipeName = HOT_RELOADABLE_SHADERS_SERVICE_PIPE;
+	unsigned int jobs = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "-pipe" && i + 1 < argc)
+			pipeName = argv[++i];
+		else if (arg == "-cache" && i + 1 < argc)
+			gCache.SetDirectory(argv[++i]);
+		else if (arg == "-jobs" && i + 1 < argc)
+			jobs = (unsigned int)atoi(argv[++i]);
+		else
+		{
+			printf("Usage: ShaderCompileDaemon [-pipe <name>] [-cache <dir>] [-jobs <count>]\n");
+			return 2;
+		}
+	}
+
+	gStopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+	SetConsoleCtrlHandler(OnConsoleControl, TRUE);
+
+	std::thread watchThread([jobs]() { WatchLoop(jobs); });
+	std::vector<std::pair<std::shared_ptr<ServiceClient>, std::thread>> clients;
+
+	printf("Compile service is listening on <%s>\n", pipeName.c_str());
+
+	// Accept processes until stop
+	while (WaitForSingleObject(gStopEvent, 0) != WAIT_OBJECT_0)
+	{
+		// Join threads of disconnected processes
+		for (auto client = clients.begin(); client != clients.end();)
+		{
+			if (!client->first->isFinished)
+			{
+				client++;
+				continue;
+			}
+			client->second.join();
+			client = clients.erase(client);
+		}
+
+		HANDLE pipe = CreateNamedPipeA(pipeName.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED, PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+			PIPE_UNLIMITED_INSTANCES, 1024 * 1024, 64 * 1024, 0, NULL);
+		if (pipe == INVALID_HANDLE_VALUE)
+		{
+			printf("Failed create pipe <%s>!\n", pipeName.c_str());
+			SetEvent(gStopEvent);
+			break;
+		}
+
+		OVERLAPPED overlapped = {};
+		overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+		DWORD bytes = 0;
+		BOOL isDone = ConnectNamedPipe(pipe, &overlapped);
+		bool isConnected = (!isDone && GetLastError() == ERROR_PIPE_CONNECTED) || WaitPipeOperation(pipe, overlapped, isDone, bytes);
+		CloseHandle(overlapped.hEvent);
+		if (!isConnected)
+		{
+			CloseHandle(pipe);
+			continue;
+		}
+
+		auto client = std::make_shared<ServiceClient>();
+		client->pipe = pipe;
+		client->isConnected = true;
+		client->isFinished = false;
+
+		printf("Client is connected\n");
+		clients.push_back({ client, std::thread(ClientLoop, client) });
+	}
+
+	// Stop event cancels reads and writes of clients, watch thread is woken
+	{
+		std::lock_guard<std::mutex> lock(gJobsMutex);
+		gIsStopping = true;
+	}
+	gJobsChanged.notify_one();
+	watchThread.join();
+
+	for (auto& client : clients)
+		client.second.join();
+
+	CloseHandle(gStopEvent);
+	printf("Compile service is stopped\n");
+	return 0;
+}
@@ -0,0 +1,502 @@
+/*
+
+	Copyright 2026 Sergey Naumenkov
+
+	File: ShaderSaveStress.cpp
+	Description: Stress harness of watcher and reader with simulated editor saves
+	Note: Replays save strategies of text editors against HotReloadableShaders (WARP device, no window)
+		  and measures missed reloads, stale reloads, duplicate compiles, torn reads and save-to-reload latency.
+		  Use it to judge watcher and debounce changes on numbers.
+
+		  Usage: ShaderSaveStress [-dir <directory>] [-iterations <count>] [-poll <ms>] [-settle <ms>] [-strategy <name|all>] [-csv <file>]
+		  Strategies: inplace, rename, recreate, rapid, duringread
+
+	Date: 18/10/2026
+
+*/
+
+#include <windows.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "HotReloadableShaders.h"
+
+// How editor is saving file
+enum class SaveStrategy
+{
+	// Truncate and write in place (two chunks)
+	InPlace,
+
+	// Write temp file and rename it over original
+	AtomicRename,
+
+	// Delete file, then create it again
+	DeleteCreate,
+
+	// Several in place saves in a row, one reload is expected
+	RapidSaves,
+
+	// In place saves with delay between chunks while other thread reads file
+	SaveDuringRead
+};
+
+// Harness options
+struct StressOptions
+{
+	std::string directory;
+	std::string strategy;
+	std::string csvPath;
+	unsigned int iterations;
+	unsigned int pollMilliseconds;
+	unsigned int settleMilliseconds;
+};
+
+// Result of one strategy
+struct StrategyResult
+{
+	const char* name;
+	unsigned int saves;
+	unsigned int failedSaves;
+	unsigned int episodes;
+	unsigned int reloads;
+
+	// No reload after last save of episode
+	unsigned int missed;
+
+	// Reloaded, but last version is not loaded
+	unsigned int stale;
+
+	// Reloads more than one per episode
+	unsigned int duplicates;
+
+	// Watcher compiled partial file
+	unsigned int compileErrors;
+
+	// ReadFile is given up
+	unsigned int readFailures;
+
+	// Reader thread (SaveDuringRead only)
+	unsigned int reads;
+	unsigned int tornReads;
+
+	std::vector<double> latencies;
+};
+
+// Reload observation, written by watcher thread
+static std::mutex gReloadsMutex;
+static std::vector<std::chrono::steady_clock::time_point> gReloads;
+
+// Counted by diagnostics sink
+static std::atomic<unsigned int> gCompileErrors;
+static std::atomic<unsigned int> gReadFailures;
+
+// Every version has same length, so torn read is found by size and markers
+static const size_t ShaderPaddingLines = 200;
+
+/// <summary>
+/// Text of shader version
+/// Body is closed at the end of file, so truncated file is not compiled
+/// </summary>
+static std::string MakeShaderText(unsigned int version)
+{
+	char line[128] = {};
+	sprintf_s(line, sizeof(line), "// begin %08u\n", version);
+	std::string text = line;
+
+	// Padding, file is big enough for chunked writes
+	for (size_t i = 0; i < ShaderPaddingLines; i++)
+		text += "// padding padding padding padding padding padding padding padding\n";
+
+	sprintf_s(line, sizeof(line), "float4 main(float4 position : SV_POSITION) : SV_TARGET\n{\n\treturn float4(%08u.0 / 16777216.0, 0.0, 0.0, 1.0);\n}\n", version);
+	text += line;
+
+	sprintf_s(line, sizeof(line), "// end %08u\n", version);
+	text += line;
+	return text;
+}
+
+/// <summary>
+/// Is text complete version of shader
+/// </summary>
+static bool IsCompleteShaderText(const std::vector<unsigned char>& buffer)
+{
+	std::string text(buffer.begin(), buffer.end());
+
+	unsigned int begin = 0;
+	unsigned int end = 0;
+	if (sscanf_s(text.c_str(), "// begin %u", &begin) != 1)
+		return false;
+
+	auto endMarker = text.rfind("// end ");
+	if (endMarker == std::string::npos || sscanf_s(text.c_str() + endMarker, "// end %u", &end) != 1)
+		return false;
+
+	return begin == end && text == MakeShaderText(begin);
+}
+
+/// <summary>
+/// Write file with CreateFile disposition, second half is written after delay
+/// Delete pending file can't be opened for a short time, it is retried like editors do
+/// </summary>
+static bool WriteShaderFile(const std::string& path, const std::string& text, DWORD disposition, unsigned int chunkDelay)
+{
+	HANDLE file = INVALID_HANDLE_VALUE;
+	for (int attempt = 0; attempt < 50 && file == INVALID_HANDLE_VALUE; attempt++)
+	{
+		file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, disposition, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			Sleep(1);
+	}
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	DWORD half = (DWORD)text.size() / 2;
+	DWORD written = 0;
+	bool isWritten = WriteFile(file, text.data(), half, &written, NULL) != FALSE;
+
+	if (chunkDelay)
+		Sleep(chunkDelay);
+
+	isWritten = isWritten && WriteFile(file, text.data() + half, (DWORD)text.size() - half, &written, NULL) != FALSE;
+	CloseHandle(file);
+	return isWritten;
+}
+
+/// <summary>
+/// Save new version of shader with strategy
+/// </summary>
+static bool SaveShader(SaveStrategy strategy, const std::string& path, unsigned int version)
+{
+	auto text = MakeShaderText(version);
+	switch (strategy)
+	{
+	case SaveStrategy::InPlace:
+	case SaveStrategy::RapidSaves:
+		return WriteShaderFile(path, text, CREATE_ALWAYS, 0);
+
+	case SaveStrategy::SaveDuringRead:
+		return WriteShaderFile(path, text, CREATE_ALWAYS, 2);
+
+	case SaveStrategy::AtomicRename:
+	{
+		auto tempPath = path + ".tmp";
+		return WriteShaderFile(tempPath, text, CREATE_ALWAYS, 0) && MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+	}
+
+	case SaveStrategy::DeleteCreate:
+		DeleteFileA(path.c_str());
+		return WriteShaderFile(path, text, CREATE_NEW, 0);
+	}
+	return false;
+}
+
+/// <summary>
+/// Hash of compiled version, compared with .cso written by watcher
+/// </summary>
+static unsigned long long GetExpectedBytecodeHash(const ShaderInformation& info, unsigned int version)
+{
+	auto text = MakeShaderText(version);
+	std::vector<unsigned char> source(text.begin(), text.end());
+
+	PreprocessedShader preprocessed = {};
+	std::vector<unsigned char> bytecode;
+	if (!PreprocessShader(info, source, preprocessed) || !CompileShaderBytecode(info, preprocessed, nullptr, bytecode))
+		return 0;
+
+	return HashBytes(bytecode.data(), bytecode.size());
+}
+
+/// <summary>
+/// Hash of .cso written by watcher
+/// </summary>
+static unsigned long long GetLoadedBytecodeHash(const ShaderInformation& info)
+{
+	std::vector<unsigned char> bytecode;
+	if (!ReadFile(GetCSOPath(info.hlslPath).c_str(), bytecode))
+		return 0;
+
+	return HashBytes(bytecode.data(), bytecode.size());
+}
+
+/// <summary>
+/// Percentile of sorted values
+/// </summary>
+static double GetPercentile(const std::vector<double>& sorted, double percentile)
+{
+	if (sorted.empty())
+		return 0.0;
+
+	auto index = (size_t)(percentile * (sorted.size() - 1) + 0.5);
+	return sorted[std::min(index, sorted.size() - 1)];
+}
+
+/// <summary>
+/// Run all episodes of one strategy
+/// </summary>
+static StrategyResult RunStrategy(SaveStrategy strategy, const char* name, ShaderInformation& info, const StressOptions& options, unsigned int& version)
+{
+	StrategyResult result = {};
+	result.name = name;
+
+	// Reader thread, checks that ReadFile never returns partial file
+	std::atomic<bool> isReading = strategy == SaveStrategy::SaveDuringRead;
+	std::atomic<unsigned int> reads = 0;
+	std::atomic<unsigned int> tornReads = 0;
+	std::thread reader([&]() {
+		std::vector<unsigned char> buffer;
+		while (isReading)
+		{
+			buffer.clear();
+			if (ReadFile(info.hlslPath, buffer))
+			{
+				reads++;
+				if (!IsCompleteShaderText(buffer))
+					tornReads++;
+			}
+		}
+	});
+
+	gCompileErrors = 0;
+	gReadFailures = 0;
+
+	for (unsigned int episode = 0; episode < options.iterations; episode++)
+	{
+		size_t reloadsBefore = 0;
+		{
+			std::lock_guard<std::mutex> lock(gReloadsMutex);
+			reloadsBefore = gReloads.size();
+		}
+
+		// Rapid saves is one episode of five saves
+		unsigned int saveCount = strategy == SaveStrategy::RapidSaves ? 5 : 1;
+		for (unsigned int i = 0; i < saveCount; i++)
+		{
+			version++;
+			result.saves++;
+			if (!SaveShader(strategy, info.hlslPath, version))
+				result.failedSaves++;
+
+			if (i + 1 < saveCount)
+				Sleep(2);
+		}
+		auto savedTime = std::chrono::steady_clock::now();
+		result.episodes++;
+
+		// Wait until watcher is quiet
+		std::this_thread::sleep_for(std::chrono::milliseconds(options.settleMilliseconds));
+
+		std::vector<std::chrono::steady_clock::time_point> reloads;
+		{
+			std::lock_guard<std::mutex> lock(gReloadsMutex);
+			reloads.assign(gReloads.begin() + reloadsBefore, gReloads.end());
+		}
+
+		result.reloads += (unsigned int)reloads.size();
+		if (reloads.size() > 1)
+			result.duplicates += (unsigned int)reloads.size() - 1;
+
+		// First reload after last save
+		auto reload = std::find_if(reloads.begin(), reloads.end(), [&](const std::chrono::steady_clock::time_point& time) { return time >= savedTime; });
+		if (reload == reloads.end())
+			result.missed++;
+		else
+			result.latencies.push_back(std::chrono::duration<double, std::milli>(*reload - savedTime).count());
+
+		// Last version must be loaded
+		if (!reloads.empty() && GetLoadedBytecodeHash(info) != GetExpectedBytecodeHash(info, version))
+			result.stale++;
+	}
+
+	isReading = false;
+	reader.join();
+
+	GetShaderDiagnostics().Flush();
+	result.compileErrors = gCompileErrors;
+	result.readFailures = gReadFailures;
+	result.reads = reads;
+	result.tornReads = tornReads;
+
+	std::sort(result.latencies.begin(), result.latencies.end());
+	return result;
+}
+
+/// <summary>
+/// Parse command line
+/// </summary>
+static bool ParseOptions(int argc, char** argv, StressOptions& options)
+{
+	options.directory = "ShaderSaveStress";
+	options.strategy = "all";
+	options.iterations = 50;
+	options.pollMilliseconds = 1;
+	options.settleMilliseconds = 300;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "-dir" && i + 1 < argc)
+			options.directory = argv[++i];
+		else if (arg == "-iterations" && i + 1 < argc)
+			options.iterations = (unsigned int)atoi(argv[++i]);
+		else if (arg == "-poll" && i + 1 < argc)
+			options.pollMilliseconds = (unsigned int)atoi(argv[++i]);
+		else if (arg == "-settle" && i + 1 < argc)
+			options.settleMilliseconds = (unsigned int)atoi(argv[++i]);
+		else if (arg == "-strategy" && i + 1 < argc)
+			options.strategy = argv[++i];
+		else if (arg == "-csv" && i + 1 < argc)
+			options.csvPath = argv[++i];
+		else
+			return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	StressOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		printf("Usage: ShaderSaveStress [-dir <directory>] [-iterations <count>] [-poll <ms>] [-settle <ms>] [-strategy <name|all>] [-csv <file>]\n");
+		return 2;
+	}
+
+	// Software device, harness runs without GPU and window
+	ID3D11Device* device = nullptr;
+	ID3D11DeviceContext* context = nullptr;
+	if (FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION, &device, nullptr, &context)))
+	{
+		printf("Failed create WARP device!\n");
+		return 1;
+	}
+
+	CreateDirectoryA(options.directory.c_str(), NULL);
+	std::string hlslPath = options.directory + "\\Stress.hlsl";
+
+	unsigned int version = 0;
+	if (!SaveShader(SaveStrategy::InPlace, hlslPath, version))
+	{
+		printf("Failed write <%s>!\n", hlslPath.c_str());
+		return 1;
+	}
+
+	// Count diagnostics instead of printing them, nothing is deduplicated or dropped
+	auto& diagnostics = GetShaderDiagnostics();
+	diagnostics.ClearSinks();
+	diagnostics.SetDeduplicationWindow(0);
+	diagnostics.SetRateLimit(0, 0);
+	diagnostics.AddSink([](const ShaderDiagnostic& diagnostic) {
+		if (diagnostic.severity == ShaderDiagnosticSeverity::Error)
+			gCompileErrors++;
+		else if (diagnostic.severity == ShaderDiagnosticSeverity::Warning && diagnostic.localName.empty())
+			gReadFailures++;
+	});
+
+	ShaderInformation info = {};
+	info.localName = "Stress";
+	info.localShaderType = HotReloadableShaderType::PixelShader;
+	info.shaderVersion = "ps_5_0";
+	info.entryPoint = "main";
+	info.hlslPath = hlslPath.c_str();
+	info.bSaveToCSO = true;
+	info.renderDevices = { device, context };
+
+	HotReloadableShaders shaders;
+	shaders.AddNewBundle(info);
+	shaders.ActionIfCompiled([]() {
+		std::lock_guard<std::mutex> lock(gReloadsMutex);
+		gReloads.push_back(std::chrono::steady_clock::now());
+	});
+
+	// Watcher, like frame loop of application
+	std::atomic<bool> isWatching = true;
+	std::thread watcher([&]() {
+		while (isWatching)
+		{
+			shaders.Start();
+			std::this_thread::sleep_for(std::chrono::milliseconds(options.pollMilliseconds));
+		}
+	});
+
+	// Initial compilation
+	std::this_thread::sleep_for(std::chrono::milliseconds(options.settleMilliseconds));
+
+	struct
+	{
+		SaveStrategy strategy;
+		const char* name;
+	} strategies[] = {
+		{ SaveStrategy::InPlace, "inplace" },
+		{ SaveStrategy::AtomicRename, "rename" },
+		{ SaveStrategy::DeleteCreate, "recreate" },
+		{ SaveStrategy::RapidSaves, "rapid" },
+		{ SaveStrategy::SaveDuringRead, "duringread" },
+	};
+
+	std::vector<StrategyResult> results;
+	for (auto& strategy : strategies)
+	{
+		if (options.strategy != "all" && options.strategy != strategy.name)
+			continue;
+
+		results.push_back(RunStrategy(strategy.strategy, strategy.name, info, options, version));
+	}
+
+	isWatching = false;
+	watcher.join();
+
+	if (results.empty())
+	{
+		printf("Unknown strategy <%s>!\n", options.strategy.c_str());
+		return 2;
+	}
+
+	// Report
+	FILE* csv = nullptr;
+	if (!options.csvPath.empty())
+	{
+		fopen_s(&csv, options.csvPath.c_str(), "w");
+		if (!csv)
+			printf("Failed create <%s>!\n", options.csvPath.c_str());
+		else
+			fprintf(csv, "strategy,saves,failedSaves,episodes,reloads,missed,stale,duplicates,compileErrors,readFailures,reads,tornReads,p50,p95,p99,max\n");
+	}
+
+	printf("%-10s %6s %6s %7s %6s %5s %10s %7s %8s %12s %8s %8s %8s %8s\n",
+		"strategy", "saves", "failed", "reloads", "missed", "stale", "duplicates", "errors", "readfail", "torn/reads", "p50 ms", "p95 ms", "p99 ms", "max ms");
+
+	int problemCount = 0;
+	for (auto& result : results)
+	{
+		auto p50 = GetPercentile(result.latencies, 0.50);
+		auto p95 = GetPercentile(result.latencies, 0.95);
+		auto p99 = GetPercentile(result.latencies, 0.99);
+		auto max = result.latencies.empty() ? 0.0 : result.latencies.back();
+
+		char tornReads[32] = {};
+		sprintf_s(tornReads, sizeof(tornReads), "%u/%u", result.tornReads, result.reads);
+
+		printf("%-10s %6u %6u %7u %6u %5u %10u %7u %8u %12s %8.2f %8.2f %8.2f %8.2f\n",
+			result.name, result.saves, result.failedSaves, result.reloads, result.missed, result.stale, result.duplicates,
+			result.compileErrors, result.readFailures, tornReads, p50, p95, p99, max);
+
+		if (csv)
+			fprintf(csv, "%s,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.3f,%.3f,%.3f,%.3f\n",
+				result.name, result.saves, result.failedSaves, result.episodes, result.reloads, result.missed, result.stale, result.duplicates,
+				result.compileErrors, result.readFailures, result.reads, result.tornReads, p50, p95, p99, max);
+
+		problemCount += result.missed + result.stale + result.tornReads;
+	}
+
+	if (csv)
+		fclose(csv);
+
+	context->Release();
+	device->Release();
+
+	// Non-zero exit code, so harness can be used in scripts
+	return problemCount ? 1 : 0;
+}